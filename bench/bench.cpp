@@ -0,0 +1,400 @@
+#include "bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace crystal::bench {
+
+/* PerfCounters */
+
+#if defined(__linux__)
+PerfCounters::PerfCounters() {
+  constexpr std::array<uint64_t, kNCounters> kConfigs = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_MISSES,
+  };
+  for (size_t i = 0; i < kNCounters; ++i) {
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = kConfigs[i];
+    attr.disabled = 1;
+    attr.inherit = 1; // count threads spawned by the benchmark too
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  for (int fd : fds_) {
+    if (fd >= 0) close(fd);
+  }
+}
+
+void PerfCounters::Start() {
+  for (int fd : fds_) {
+    if (fd < 0) continue;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+PerfCounters::Values PerfCounters::Stop() {
+  Values values{};
+  for (size_t i = 0; i < kNCounters; ++i) {
+    if (fds_[i] < 0) continue;
+    ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fds_[i], &values[i], sizeof(uint64_t)) != sizeof(uint64_t)) {
+      values[i] = 0;
+    }
+  }
+  return values;
+}
+#else
+PerfCounters::PerfCounters() {
+  fds_.fill(-1);
+}
+PerfCounters::~PerfCounters() = default;
+void PerfCounters::Start() {
+}
+PerfCounters::Values PerfCounters::Stop() {
+  return {};
+}
+#endif
+
+bool PerfCounters::any_available() const {
+  return std::ranges::any_of(fds_, [](int fd) { return fd >= 0; });
+}
+
+/* State */
+
+void State::StartTimer() {
+  if (counters_) counters_->Start();
+  start_ = std::chrono::steady_clock::now();
+}
+
+void State::StopTimer() {
+  auto stop = std::chrono::steady_clock::now();
+  if (counters_) counter_values_ = counters_->Stop();
+  elapsed_ns_ = std::chrono::duration<double, std::nano>(stop - start_).count();
+}
+
+/* Registry */
+
+namespace {
+
+struct Benchmark {
+  std::string name;
+  Function fn;
+  std::vector<int64_t> args;
+};
+
+std::vector<Benchmark>& Registry() {
+  static std::vector<Benchmark> registry;
+  return registry;
+}
+
+struct Options {
+  std::string filter;
+  std::string json_path;
+  size_t repetitions = 5;
+  double min_time_ms = 50;
+  bool counters = true;
+};
+
+struct Stat {
+  double mean = 0;
+  double stddev = 0;
+};
+
+Stat Summarize(const std::vector<double>& samples) {
+  Stat stat;
+  if (samples.empty()) return stat;
+  for (double s : samples) stat.mean += s;
+  stat.mean /= static_cast<double>(samples.size());
+  if (samples.size() > 1) {
+    double sq = 0;
+    for (double s : samples) sq += (s - stat.mean) * (s - stat.mean);
+    stat.stddev = std::sqrt(sq / static_cast<double>(samples.size() - 1));
+  }
+  return stat;
+}
+
+struct Result {
+  std::string name;
+  size_t iterations = 0;
+  size_t repetitions = 0;
+  Stat ns_per_op;
+  double items_per_second = 0;
+  double bytes_per_second = 0;
+  std::array<double, PerfCounters::kNCounters> counters_per_op{};
+  std::array<bool, PerfCounters::kNCounters> counters_valid{};
+};
+
+std::string JsonEscape(std::string_view str) {
+  std::string res;
+  for (char c : str) {
+    if (c == '"' || c == '\\') res += '\\';
+    res += c;
+  }
+  return res;
+}
+
+} // namespace
+
+bool Register(std::string name, Function fn, std::vector<int64_t> args) {
+  Registry().push_back({ std::move(name), std::move(fn), std::move(args) });
+  return true;
+}
+
+std::vector<int64_t> Range(int64_t lo, int64_t hi, int64_t mult) {
+  if (lo <= 0 || mult <= 1) {
+    throw std::invalid_argument{ "Range needs lo > 0 and mult > 1." };
+  }
+  std::vector<int64_t> res;
+  for (int64_t i = lo; i < hi; i *= mult) res.push_back(i);
+  res.push_back(hi);
+  return res;
+}
+
+std::vector<int64_t> ThreadCounts() {
+  int64_t n = std::max(1u, std::thread::hardware_concurrency());
+  return Range(1, n);
+}
+
+struct Runner {
+  static State Run(const Function& fn,
+                   size_t iterations,
+                   int64_t arg,
+                   PerfCounters* counters) {
+    State state{ iterations, arg, counters };
+    fn(state);
+    return state;
+  }
+
+  static Result Measure(const std::string& name,
+                        const Function& fn,
+                        int64_t arg,
+                        const Options& options,
+                        PerfCounters* counters) {
+    /* Grow the iteration count until one run takes the minimum time. */
+    const double min_ns = options.min_time_ms * 1e6;
+    size_t iterations = 1;
+    for (;;) {
+      State state = Run(fn, iterations, arg, nullptr);
+      if (state.elapsed_ns_ >= min_ns || iterations >= (size_t{ 1 } << 40)) {
+        break;
+      }
+      double scale = state.elapsed_ns_ > 0 ? min_ns / state.elapsed_ns_ * 1.2
+                                           : 100;
+      iterations = static_cast<size_t>(
+          static_cast<double>(iterations) * std::clamp(scale, 2.0, 100.0));
+    }
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.repetitions = options.repetitions;
+    std::vector<double> ns_per_op;
+    double items = 0, bytes = 0, seconds = 0;
+    std::array<double, PerfCounters::kNCounters> counter_sum{};
+    for (size_t rep = 0; rep < options.repetitions; ++rep) {
+      State state = Run(fn, iterations, arg, counters);
+      double n = static_cast<double>(iterations);
+      ns_per_op.push_back(state.elapsed_ns_ / n);
+      seconds += state.elapsed_ns_ * 1e-9;
+      items += static_cast<double>(state.items_per_iteration_) * n;
+      bytes += static_cast<double>(state.bytes_per_iteration_) * n;
+      for (size_t i = 0; i < PerfCounters::kNCounters; ++i) {
+        counter_sum[i] += static_cast<double>(state.counter_values_[i]) / n;
+      }
+    }
+    result.ns_per_op = Summarize(ns_per_op);
+    if (seconds > 0) {
+      result.items_per_second = items / seconds;
+      result.bytes_per_second = bytes / seconds;
+    }
+    for (size_t i = 0; i < PerfCounters::kNCounters; ++i) {
+      result.counters_valid[i] = counters && counters->available(i);
+      result.counters_per_op[i] =
+          counter_sum[i] / static_cast<double>(options.repetitions);
+    }
+    return result;
+  }
+};
+
+namespace {
+
+void PrintHeader() {
+  std::printf("%-48s %12s %10s %14s %12s %10s %10s\n",
+              "benchmark",
+              "ns/op",
+              "stddev",
+              "items/s",
+              "bytes/s",
+              "cycles/op",
+              "instr/op");
+}
+
+void PrintResult(const Result& r) {
+  auto counter = [&r](size_t idx, char* buf, size_t len) {
+    if (r.counters_valid[idx]) {
+      std::snprintf(buf, len, "%.2f", r.counters_per_op[idx]);
+    } else {
+      std::snprintf(buf, len, "n/a");
+    }
+  };
+  char cycles[32], instructions[32];
+  counter(0, cycles, sizeof(cycles));
+  counter(1, instructions, sizeof(instructions));
+  std::printf("%-48s %12.3f %9.2f%% %14.4g %12.4g %10s %10s\n",
+              r.name.c_str(),
+              r.ns_per_op.mean,
+              r.ns_per_op.mean > 0 ? r.ns_per_op.stddev / r.ns_per_op.mean * 100
+                                   : 0,
+              r.items_per_second,
+              r.bytes_per_second,
+              cycles,
+              instructions);
+}
+
+void WriteJson(std::ostream& os, const std::vector<Result>& results) {
+  os << "{\n  \"context\": {\"hardware_threads\": "
+     << std::thread::hardware_concurrency() << "},\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    os << (i ? ",\n" : "\n") << "    {\"name\": \"" << JsonEscape(r.name)
+       << "\", \"iterations\": " << r.iterations
+       << ", \"repetitions\": " << r.repetitions
+       << ", \"ns_per_op\": " << r.ns_per_op.mean
+       << ", \"ns_per_op_stddev\": " << r.ns_per_op.stddev
+       << ", \"items_per_second\": " << r.items_per_second
+       << ", \"bytes_per_second\": " << r.bytes_per_second
+       << ", \"counters\": {";
+    bool first = true;
+    for (size_t c = 0; c < PerfCounters::kNCounters; ++c) {
+      if (!r.counters_valid[c]) continue;
+      os << (first ? "" : ", ") << '"' << PerfCounters::kNames[c]
+         << "_per_op\": " << r.counters_per_op[c];
+      first = false;
+    }
+    os << "}}";
+  }
+  os << "\n  ]\n}\n";
+}
+
+/* Parse all of `str` into `out`, false if malformed. */
+template <typename T>
+bool ParseNumber(std::string_view str, T& out) {
+  T value{};
+  auto res = std::from_chars(str.data(), str.data() + str.size(), value);
+  if (res.ec != std::errc{} || res.ptr != str.data() + str.size()) return false;
+  out = value;
+  return true;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    auto value = [&arg](std::string_view flag) -> std::string_view {
+      return arg.starts_with(flag) ? arg.substr(flag.size()) : std::string_view{};
+    };
+    bool valid = true;
+    if (arg.starts_with("--filter=")) {
+      options.filter = value("--filter=");
+    } else if (arg.starts_with("--json=")) {
+      options.json_path = value("--json=");
+    } else if (arg.starts_with("--repetitions=")) {
+      valid = ParseNumber(value("--repetitions="), options.repetitions)
+           && options.repetitions >= 1;
+    } else if (arg.starts_with("--min_time_ms=")) {
+      valid = ParseNumber(value("--min_time_ms="), options.min_time_ms)
+           && options.min_time_ms >= 0;
+    } else if (arg == "--no_counters") {
+      options.counters = false;
+    } else {
+      valid = false;
+    }
+    if (!valid) {
+      std::fprintf(stderr,
+                   "usage: %s [--filter=substr] [--json=path|-] "
+                   "[--repetitions=n] [--min_time_ms=ms] [--no_counters]\n",
+                   argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int Main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) return 1;
+
+  PerfCounters counters;
+  PerfCounters* active_counters =
+      options.counters && counters.any_available() ? &counters : nullptr;
+  if (options.counters && !active_counters) {
+    std::fprintf(stderr, "note: hardware counters unavailable\n");
+  }
+
+  auto& registry = Registry();
+  std::ranges::stable_sort(registry, {}, &Benchmark::name);
+
+  bool json_to_stdout = options.json_path == "-";
+  if (!json_to_stdout) PrintHeader();
+  std::vector<Result> results;
+  for (const Benchmark& bm : registry) {
+    std::vector<int64_t> args = bm.args;
+    if (args.empty()) args.push_back(0);
+    for (int64_t arg : args) {
+      std::string name = bm.name;
+      if (!bm.args.empty()) name += '/' + std::to_string(arg);
+      if (name.find(options.filter) == std::string::npos) continue;
+      results.push_back(
+          Runner::Measure(name, bm.fn, arg, options, active_counters));
+      if (!json_to_stdout) {
+        PrintResult(results.back());
+        std::fflush(stdout);
+      }
+    }
+  }
+
+  if (json_to_stdout) {
+    WriteJson(std::cout, results);
+  } else if (!options.json_path.empty()) {
+    std::ofstream os{ options.json_path };
+    if (!os.good()) {
+      std::fprintf(stderr, "cannot write %s\n", options.json_path.c_str());
+      return 1;
+    }
+    WriteJson(os, results);
+  }
+  return 0;
+}
+
+} // namespace crystal::bench
+
+int main(int argc, char** argv) {
+  return crystal::bench::Main(argc, argv);
+}
@@ -0,0 +1,212 @@
+#ifndef CRYSTALBASE_BENCH_BENCH_H_
+#define CRYSTALBASE_BENCH_BENCH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace crystal::bench {
+
+/**
+ * Hardware counters of the calling thread (and of threads it spawns).
+ *
+ * Backed by `perf_event_open` on Linux. Counters the kernel refuses (no PMU,
+ * restrictive `perf_event_paranoid`, non Linux hosts) are reported as
+ * unavailable instead of failing the run.
+ */
+class PerfCounters {
+ public:
+  static constexpr size_t kNCounters = 4;
+  static constexpr std::array<std::string_view, kNCounters> kNames = {
+    "cycles",
+    "instructions",
+    "branch_misses",
+    "cache_misses",
+  };
+
+  using Values = std::array<uint64_t, kNCounters>;
+
+  /* Constructor */
+  PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  /* Destructor */
+  ~PerfCounters();
+
+  bool available(size_t idx) const {
+    return fds_[idx] >= 0;
+  }
+  bool any_available() const;
+
+  void Start();
+  Values Stop();
+
+ private:
+  std::array<int, kNCounters> fds_;
+};
+
+/**
+ * Per run state handed to a benchmark.
+ *
+ * Iterate the state with a range based for loop: the timer covers the loop
+ * only, so setup before it and teardown after it are not measured.
+ *
+ * ```
+ * void Foo(bench::State& state) {
+ *   std::vector<int> v(1024);
+ *   for (auto _ : state) bench::DoNotOptimize(v.data());
+ * }
+ * ```
+ */
+class State {
+ public:
+  class Iterator {
+   public:
+    /* Non trivial so `for (auto _ : state)` raises no unused warnings. */
+    struct Value {
+      ~Value() {
+      }
+    };
+
+    Value operator*() const {
+      return {};
+    }
+    Iterator& operator++() {
+      --remaining_;
+      return *this;
+    }
+    bool operator!=(const Iterator&) {
+      if (remaining_ != 0) [[likely]] return true;
+      state_->StopTimer();
+      return false;
+    }
+
+   private:
+    friend class State;
+    Iterator(State* state, size_t remaining) :
+        state_{ state }, remaining_{ remaining } {
+    }
+
+    State* state_;
+    size_t remaining_;
+  };
+
+  /* Constructor */
+  State(size_t iterations, int64_t arg, PerfCounters* counters) :
+      iterations_{ iterations }, arg_{ arg }, counters_{ counters } {
+  }
+
+  Iterator begin() {
+    StartTimer();
+    return { this, iterations_ };
+  }
+  Iterator end() {
+    return { this, 0 };
+  }
+
+  /* Accessors */
+  size_t iterations() const {
+    return iterations_;
+  }
+  /* The argument the benchmark was registered with, 0 if none. */
+  int64_t arg() const {
+    return arg_;
+  }
+
+  /* Throughput, per iteration of the loop. */
+  void SetItemsPerIteration(uint64_t n) {
+    items_per_iteration_ = n;
+  }
+  void SetBytesPerIteration(uint64_t n) {
+    bytes_per_iteration_ = n;
+  }
+
+ private:
+  friend struct Runner;
+
+  void StartTimer();
+  void StopTimer();
+
+  size_t iterations_;
+  int64_t arg_;
+  PerfCounters* counters_;
+  uint64_t items_per_iteration_ = 1;
+  uint64_t bytes_per_iteration_ = 0;
+  std::chrono::steady_clock::time_point start_{};
+  double elapsed_ns_ = 0;
+  PerfCounters::Values counter_values_{};
+};
+
+using Function = std::function<void(State&)>;
+
+/**
+ * Register a benchmark, returns true so it can initialize a static.
+ *
+ * @param name Name of the benchmark. By convention `operation/implementation`
+ * so that a library case sorts next to its `std` baseline.
+ * @param args Arguments to run the benchmark with, one run per argument.
+ */
+bool Register(std::string name, Function fn, std::vector<int64_t> args = {});
+
+/**
+ * Arguments `lo, lo * mult, ...` up to and including `hi`.
+ *
+ * @note Throws `std::invalid_argument` unless `lo > 0` and `mult > 1`.
+ */
+std::vector<int64_t> Range(int64_t lo, int64_t hi, int64_t mult = 2);
+/* Thread counts from 1 to all hardware threads, doubling. */
+std::vector<int64_t> ThreadCounts();
+
+/* Run the benchmarks selected by the command line, returns the exit code. */
+int Main(int argc, char** argv);
+
+/* Prevent the optimizer from discarding a value. */
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r"(&value) : "memory");
+}
+template <typename T>
+inline void DoNotOptimize(T& value) {
+  if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(void*)) {
+    asm volatile("" : "+m,r"(value) : : "memory");
+  } else if constexpr (std::is_trivially_copyable_v<T>) {
+    asm volatile("" : "+m"(value) : : "memory");
+  } else {
+    asm volatile("" : : "r"(&value) : "memory"); // escape the object
+  }
+}
+/* Force pending writes to memory. */
+inline void ClobberMemory() {
+  asm volatile("" : : : "memory");
+}
+
+} // namespace crystal::bench
+
+#define CRYSTAL_BENCH_CONCAT_IMPL(a, b) a##b
+#define CRYSTAL_BENCH_CONCAT(a, b) CRYSTAL_BENCH_CONCAT_IMPL(a, b)
+
+/* Register a benchmark function (or template instantiation) under a name. */
+#define CRYSTAL_BENCHMARK(name, ...)                                      \
+  [[maybe_unused]] static const bool CRYSTAL_BENCH_CONCAT(                \
+      kCrystalBenchRegistered, __COUNTER__) =                             \
+      ::crystal::bench::Register(name, __VA_ARGS__)
+
+/**
+ * Register a benchmark that runs once per argument.
+ *
+ * `args` is an expression yielding the arguments, e.g. `bench::Range(1, 64)`.
+ */
+#define CRYSTAL_BENCHMARK_ARGS(name, args, ...)                           \
+  [[maybe_unused]] static const bool CRYSTAL_BENCH_CONCAT(                \
+      kCrystalBenchRegistered, __COUNTER__) =                             \
+      ::crystal::bench::Register(name, __VA_ARGS__, args)
+
+#endif
@@ -0,0 +1,82 @@
+#include <bit>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+#include "CrystalBase/bitwise.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::operator-;
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+constexpr size_t kN = 1024;
+
+std::vector<uint64_t> Inputs() {
+  std::vector<uint64_t> v(kN);
+  uint64_t x = 0x9e3779b97f4a7c15ull;
+  for (auto& e : v) {
+    x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+    e = x;
+  }
+  return v;
+}
+
+template <size_t kBits>
+void LowbitBitset(State& state) {
+  std::vector<std::bitset<kBits>> in;
+  for (uint64_t v : Inputs()) in.emplace_back(v);
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    for (const auto& bits : in) DoNotOptimize(crystal::lowbit(bits));
+  }
+}
+
+void LowbitUnsigned(State& state) {
+  auto in = Inputs();
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    for (uint64_t bits : in) DoNotOptimize(crystal::lowbit(bits));
+  }
+}
+
+/* std baseline: isolate the lowest set bit through <bit>. */
+void LowbitStd(State& state) {
+  auto in = Inputs();
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    for (uint64_t bits : in) {
+      DoNotOptimize(bits ? uint64_t{ 1 } << std::countr_zero(bits) : 0);
+    }
+  }
+}
+
+template <size_t kBits>
+void NegateBitset(State& state) {
+  std::vector<std::bitset<kBits>> in;
+  for (uint64_t v : Inputs()) in.emplace_back(v);
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    for (const auto& bits : in) DoNotOptimize(-bits);
+  }
+}
+
+/* std baseline: two's complement through ~bits + 1 on the integer value. */
+void NegateStd(State& state) {
+  auto in = Inputs();
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    for (uint64_t bits : in) DoNotOptimize(std::bitset<64>(~bits + 1));
+  }
+}
+
+} // namespace
+
+CRYSTAL_BENCHMARK("lowbit/crystal::lowbit(bitset<64>)", LowbitBitset<64>);
+CRYSTAL_BENCHMARK("lowbit/crystal::lowbit(bitset<256>)", LowbitBitset<256>);
+CRYSTAL_BENCHMARK("lowbit/crystal::lowbit(uint64_t)", LowbitUnsigned);
+CRYSTAL_BENCHMARK("lowbit/std::countr_zero", LowbitStd);
+CRYSTAL_BENCHMARK("negate/crystal::operator-(bitset<64>)", NegateBitset<64>);
+CRYSTAL_BENCHMARK("negate/std::bitset(~x+1)", NegateStd);
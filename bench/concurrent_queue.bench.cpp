@@ -0,0 +1,165 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "CrystalBase/concurrent_queue.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+constexpr size_t kCapacity = 1024;
+constexpr uint64_t kMessages = 1 << 18;
+constexpr size_t kBatch = 32;
+constexpr uint64_t kStop = ~uint64_t{ 0 };
+
+/* The baseline: a bounded deque behind a mutex and two condition variables. */
+class MutexQueue {
+ public:
+  void push(uint64_t item) {
+    std::unique_lock lock{ mutex_ };
+    not_full_.wait(lock, [&] { return items_.size() < kCapacity; });
+    items_.push_back(item);
+    lock.unlock();
+    not_empty_.notify_one();
+  }
+  uint64_t pop() {
+    std::unique_lock lock{ mutex_ };
+    not_empty_.wait(lock, [&] { return !items_.empty(); });
+    uint64_t item = items_.front();
+    items_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return item;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<uint64_t> items_;
+};
+
+using Spsc = crystal::spsc_queue<uint64_t, kCapacity>;
+using Mpmc = crystal::mpmc_queue<uint64_t, kCapacity>;
+
+template <bool kBatched, typename Queue>
+void Produce(Queue& queue, uint64_t count) {
+  if constexpr (kBatched) {
+    uint64_t batch[kBatch];
+    for (uint64_t i = 0; i < count;) {
+      const size_t n = std::min<uint64_t>(kBatch, count - i);
+      std::iota(batch, batch + n, i);
+      for (size_t pushed = 0; pushed < n;) {
+        size_t k = queue.try_push_n(batch + pushed, n - pushed);
+        if (k == 0) std::this_thread::yield();
+        pushed += k;
+      }
+      i += n;
+    }
+  } else {
+    for (uint64_t i = 0; i < count; ++i) queue.push(i);
+  }
+}
+
+template <bool kBatched, typename Queue>
+uint64_t Consume(Queue& queue, uint64_t count) {
+  uint64_t sum = 0;
+  if constexpr (kBatched) {
+    uint64_t batch[kBatch];
+    for (uint64_t i = 0; i < count;) {
+      size_t k = queue.try_pop_n(batch, std::min<uint64_t>(kBatch, count - i));
+      if (k == 0) std::this_thread::yield();
+      for (size_t j = 0; j < k; ++j) sum += batch[j];
+      i += k;
+    }
+  } else {
+    for (uint64_t i = 0; i < count; ++i) sum += queue.pop();
+  }
+  return sum;
+}
+
+/* `threads` producers and as many consumers pass kMessages through `queue`. */
+template <bool kBatched, typename Queue>
+void Pipe(Queue& queue, size_t threads) {
+  const uint64_t share = kMessages / threads;
+  std::vector<std::thread> pool;
+  for (size_t t = 0; t < threads; ++t) {
+    pool.emplace_back([&] { Produce<kBatched>(queue, share); });
+  }
+  for (size_t t = 1; t < threads; ++t) {
+    pool.emplace_back([&] { DoNotOptimize(Consume<kBatched>(queue, share)); });
+  }
+  DoNotOptimize(Consume<kBatched>(queue, share));
+  for (std::thread& thread : pool) thread.join();
+}
+
+/* Throughput with one producer and one consumer. */
+template <typename Queue, bool kBatched = false>
+void PipeOneToOne(State& state) {
+  auto queue = std::make_unique<Queue>();
+  state.SetItemsPerIteration(kMessages);
+  for (auto _ : state) Pipe<kBatched>(*queue, 1);
+}
+
+/* Throughput with `arg` producers and `arg` consumers. */
+template <typename Queue, bool kBatched = false>
+void PipeManyToMany(State& state) {
+  auto queue = std::make_unique<Queue>();
+  state.SetItemsPerIteration(kMessages);
+  for (auto _ : state) Pipe<kBatched>(*queue, state.arg());
+}
+
+/* Latency: a message to an echo thread and back, through two queues. */
+template <typename Queue>
+void RoundTrip(State& state) {
+  auto ping = std::make_unique<Queue>();
+  auto pong = std::make_unique<Queue>();
+  std::thread echo{ [&] {
+    uint64_t item;
+    do {
+      item = ping->pop();
+      pong->push(item);
+    } while (item != kStop);
+  } };
+  uint64_t i = 0;
+  for (auto _ : state) {
+    ping->push(i++);
+    DoNotOptimize(pong->pop());
+  }
+  ping->push(kStop);
+  pong->pop();
+  echo.join();
+}
+
+const auto kThreads = crystal::bench::ThreadCounts();
+
+} // namespace
+
+CRYSTAL_BENCHMARK("throughput_1p1c/crystal::spsc_queue", PipeOneToOne<Spsc>);
+CRYSTAL_BENCHMARK("throughput_1p1c/crystal::spsc_queue_batch",
+                  PipeOneToOne<Spsc, true>);
+CRYSTAL_BENCHMARK("throughput_1p1c/crystal::mpmc_queue", PipeOneToOne<Mpmc>);
+CRYSTAL_BENCHMARK("throughput_1p1c/std::mutex", PipeOneToOne<MutexQueue>);
+CRYSTAL_BENCHMARK_ARGS("throughput_npnc/crystal::mpmc_queue",
+                       kThreads,
+                       PipeManyToMany<Mpmc>);
+CRYSTAL_BENCHMARK_ARGS("throughput_npnc/crystal::mpmc_queue_batch",
+                       kThreads,
+                       PipeManyToMany<Mpmc, true>);
+CRYSTAL_BENCHMARK_ARGS("throughput_npnc/std::mutex",
+                       kThreads,
+                       PipeManyToMany<MutexQueue>);
+CRYSTAL_BENCHMARK("round_trip/crystal::spsc_queue", RoundTrip<Spsc>);
+CRYSTAL_BENCHMARK("round_trip/crystal::mpmc_queue", RoundTrip<Mpmc>);
+CRYSTAL_BENCHMARK("round_trip/std::mutex", RoundTrip<MutexQueue>);
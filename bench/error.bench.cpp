@@ -0,0 +1,71 @@
+#include <expected>
+#include <string>
+#include <string_view>
+
+#include "CrystalBase/error.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::State;
+
+/* The previous, heap allocating, error representation. */
+struct StringError {
+  std::string str;
+  std::string_view msg() const {
+    return str;
+  }
+};
+
+/* Keep the optimizer from folding the error path away. */
+volatile int g_fail = 1;
+
+template <typename E, typename MakeError>
+[[gnu::noinline]] std::expected<int, E> MayFail(int i, MakeError make_error) {
+  if (g_fail) return std::unexpected(make_error(i));
+  return i;
+}
+
+template <typename E, typename MakeError>
+void ErrorPath(State& state, MakeError make_error) {
+  size_t checksum = 0;
+  int i = 0;
+  for (auto _ : state) {
+    auto res = MayFail<E>(i++, make_error);
+    if (!res) checksum += res.error().msg().size();
+  }
+  crystal::bench::DoNotOptimize(checksum);
+}
+
+void Literal(State& state) {
+  ErrorPath<crystal::Error>(state, [](int) {
+    return crystal::Error{ "Cannot open file.", crystal::ErrorCategory::kIo };
+  });
+}
+
+void FixedString(State& state) {
+  ErrorPath<crystal::Error>(state, [](int) {
+    return crystal::Error::Make<"Cannot open file.">(crystal::ErrorCategory::kIo);
+  });
+}
+
+void Inline(State& state) {
+  ErrorPath<crystal::Error>(state, [](int i) {
+    return crystal::Error::Inline(i & 1 ? "short read" : "unexpected end of file",
+                                  crystal::ErrorCategory::kIo);
+  });
+}
+
+void String(State& state) {
+  ErrorPath<StringError>(state, [](int i) {
+    return StringError{ i & 1 ? "short read on descriptor, retry later"
+                              : "unexpected end of file while parsing" };
+  });
+}
+
+} // namespace
+
+CRYSTAL_BENCHMARK("error_path/crystal::Error(literal)", Literal);
+CRYSTAL_BENCHMARK("error_path/crystal::Error(fixed_string)", FixedString);
+CRYSTAL_BENCHMARK("error_path/crystal::Error(inline)", Inline);
+CRYSTAL_BENCHMARK("error_path/std::string", String);
@@ -0,0 +1,75 @@
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "CrystalBase/fixed_string.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+constexpr crystal::fixed_string kShort{ "position" };
+constexpr crystal::fixed_string kLong{
+  "a_rather_long_identifier_used_as_a_component_name"
+};
+
+template <auto kStr>
+void HashFixedString(State& state) {
+  auto str = kStr;
+  state.SetBytesPerIteration(str.size());
+  for (auto _ : state) {
+    DoNotOptimize(str);
+    DoNotOptimize(std::hash<decltype(str)>{}(str));
+  }
+}
+
+template <auto kStr>
+void HashStringView(State& state) {
+  std::string_view str = kStr;
+  state.SetBytesPerIteration(str.size());
+  for (auto _ : state) {
+    DoNotOptimize(str);
+    DoNotOptimize(std::hash<std::string_view>{}(str));
+  }
+}
+
+template <auto kStr>
+void HashString(State& state) {
+  std::string str{ std::string_view{ kStr } };
+  state.SetBytesPerIteration(str.size());
+  for (auto _ : state) {
+    DoNotOptimize(str);
+    DoNotOptimize(std::hash<std::string>{}(str));
+  }
+}
+
+template <auto kStr>
+void EqualFixedString(State& state) {
+  auto a = kStr, b = kStr;
+  for (auto _ : state) {
+    DoNotOptimize(a);
+    DoNotOptimize(a == b);
+  }
+}
+
+template <auto kStr>
+void EqualString(State& state) {
+  std::string a{ std::string_view{ kStr } }, b = a;
+  for (auto _ : state) {
+    DoNotOptimize(a);
+    DoNotOptimize(a == b);
+  }
+}
+
+} // namespace
+
+CRYSTAL_BENCHMARK("hash_8/crystal::fixed_string", HashFixedString<kShort>);
+CRYSTAL_BENCHMARK("hash_8/std::string_view", HashStringView<kShort>);
+CRYSTAL_BENCHMARK("hash_8/std::string", HashString<kShort>);
+CRYSTAL_BENCHMARK("hash_49/crystal::fixed_string", HashFixedString<kLong>);
+CRYSTAL_BENCHMARK("hash_49/std::string_view", HashStringView<kLong>);
+CRYSTAL_BENCHMARK("hash_49/std::string", HashString<kLong>);
+CRYSTAL_BENCHMARK("equal_49/crystal::fixed_string", EqualFixedString<kLong>);
+CRYSTAL_BENCHMARK("equal_49/std::string", EqualString<kLong>);
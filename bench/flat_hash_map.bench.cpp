@@ -0,0 +1,120 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CrystalBase/flat_hash_map.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+using FlatMap = crystal::flat_hash_map<uint64_t, uint64_t>;
+using StdMap = std::unordered_map<uint64_t, uint64_t>;
+using FlatStringMap = crystal::flat_hash_map<std::string, uint64_t>;
+using StdStringMap = std::unordered_map<std::string, uint64_t>;
+
+/* `n` distinct random keys; the upper half of the range is never inserted. */
+std::vector<uint64_t> Keys(size_t n, bool hit = true) {
+  std::mt19937_64 rng{ 42 };
+  std::vector<uint64_t> keys(n);
+  for (uint64_t& key : keys) key = (rng() >> 1) | (hit ? 0 : 1ull << 63);
+  return keys;
+}
+
+template <typename Key>
+Key MakeKey(uint64_t key) {
+  if constexpr (std::is_same_v<Key, std::string>) {
+    return "key/" + std::to_string(key);
+  } else {
+    return key;
+  }
+}
+
+template <typename Map>
+Map Filled(const std::vector<uint64_t>& keys) {
+  Map map;
+  for (uint64_t key : keys) map[MakeKey<typename Map::key_type>(key)] = key;
+  return map;
+}
+
+template <typename Map>
+void Insert(State& state) {
+  auto keys = Keys(state.arg());
+  state.SetItemsPerIteration(keys.size());
+  for (auto _ : state) {
+    Map map;
+    for (uint64_t key : keys) map.emplace(key, key);
+    DoNotOptimize(map);
+  }
+}
+
+template <typename Map>
+void Lookup(State& state, bool hit) {
+  using Key = typename Map::key_type;
+  Map map = Filled<Map>(Keys(state.arg()));
+  std::vector<Key> probes;
+  for (uint64_t key : Keys(state.arg(), hit)) probes.push_back(MakeKey<Key>(key));
+  state.SetItemsPerIteration(probes.size());
+  for (auto _ : state) {
+    size_t found = 0;
+    for (const Key& key : probes) found += map.find(key) != map.end();
+    DoNotOptimize(found);
+  }
+}
+template <typename Map>
+void LookupHit(State& state) {
+  Lookup<Map>(state, true);
+}
+template <typename Map>
+void LookupMiss(State& state) {
+  Lookup<Map>(state, false);
+}
+
+/* Erase everything, then put it back for the next iteration. */
+template <typename Map>
+void EraseInsert(State& state) {
+  auto keys = Keys(state.arg());
+  Map map = Filled<Map>(keys);
+  state.SetItemsPerIteration(keys.size() * 2);
+  for (auto _ : state) {
+    for (uint64_t key : keys) map.erase(key);
+    for (uint64_t key : keys) map.emplace(key, key);
+    DoNotOptimize(map);
+  }
+}
+
+const auto kSizes = crystal::bench::Range(1 << 10, 1 << 20, 32);
+
+} // namespace
+
+CRYSTAL_BENCHMARK_ARGS("insert/crystal::flat_hash_map", kSizes, Insert<FlatMap>);
+CRYSTAL_BENCHMARK_ARGS("insert/std::unordered_map", kSizes, Insert<StdMap>);
+CRYSTAL_BENCHMARK_ARGS("lookup_hit/crystal::flat_hash_map",
+                       kSizes,
+                       LookupHit<FlatMap>);
+CRYSTAL_BENCHMARK_ARGS("lookup_hit/std::unordered_map",
+                       kSizes,
+                       LookupHit<StdMap>);
+CRYSTAL_BENCHMARK_ARGS("lookup_miss/crystal::flat_hash_map",
+                       kSizes,
+                       LookupMiss<FlatMap>);
+CRYSTAL_BENCHMARK_ARGS("lookup_miss/std::unordered_map",
+                       kSizes,
+                       LookupMiss<StdMap>);
+CRYSTAL_BENCHMARK_ARGS("erase_insert/crystal::flat_hash_map",
+                       kSizes,
+                       EraseInsert<FlatMap>);
+CRYSTAL_BENCHMARK_ARGS("erase_insert/std::unordered_map",
+                       kSizes,
+                       EraseInsert<StdMap>);
+CRYSTAL_BENCHMARK_ARGS("lookup_hit_string/crystal::flat_hash_map",
+                       kSizes,
+                       LookupHit<FlatStringMap>);
+CRYSTAL_BENCHMARK_ARGS("lookup_hit_string/std::unordered_map",
+                       kSizes,
+                       LookupHit<StdStringMap>);
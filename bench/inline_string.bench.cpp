@@ -0,0 +1,89 @@
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "CrystalBase/hash.h"
+#include "CrystalBase/inline_string.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+/* 15 chars fit libstdc++'s small string buffer, 40 do not. */
+constexpr std::string_view kParts[] = { "user", "/", "session", "/", "id" };
+constexpr std::string_view kLongParts[] = {
+  "user/4b1d9c2e", "/", "session/77a3f0de", "/", "id/0042",
+};
+
+template <typename S, const auto& kPieces>
+void Build(State& state) {
+  for (auto _ : state) {
+    S str;
+    for (std::string_view part : kPieces) str += part;
+    DoNotOptimize(str);
+  }
+}
+
+template <typename S, const auto& kPieces>
+void Copy(State& state) {
+  S src;
+  for (std::string_view part : kPieces) src += part;
+  for (auto _ : state) {
+    S copy = src;
+    DoNotOptimize(copy);
+  }
+}
+
+template <typename S, const auto& kPieces>
+void Hash(State& state) {
+  S str;
+  for (std::string_view part : kPieces) str += part;
+  for (auto _ : state) {
+    DoNotOptimize(str);
+    DoNotOptimize(std::hash<S>{}(str));
+  }
+}
+
+template <typename S, const auto& kPieces>
+void MapLookup(State& state) {
+  constexpr size_t kNKeys = 1024;
+  std::vector<S> keys;
+  std::unordered_map<S, size_t> map;
+  for (size_t i = 0; i < kNKeys; ++i) {
+    S key;
+    for (std::string_view part : kPieces) key += part;
+    key += std::to_string(i);
+    keys.push_back(key);
+    map.emplace(key, i);
+  }
+  state.SetItemsPerIteration(kNKeys);
+  for (auto _ : state) {
+    size_t sum = 0;
+    for (const auto& key : keys) sum += map.find(key)->second;
+    DoNotOptimize(sum);
+  }
+}
+
+using Inline = crystal::inline_string<63>;
+
+} // namespace
+
+CRYSTAL_BENCHMARK("build_15/crystal::inline_string", Build<Inline, kParts>);
+CRYSTAL_BENCHMARK("build_15/std::string", Build<std::string, kParts>);
+CRYSTAL_BENCHMARK("build_40/crystal::inline_string", Build<Inline, kLongParts>);
+CRYSTAL_BENCHMARK("build_40/std::string", Build<std::string, kLongParts>);
+CRYSTAL_BENCHMARK("copy_15/crystal::inline_string", Copy<Inline, kParts>);
+CRYSTAL_BENCHMARK("copy_15/std::string", Copy<std::string, kParts>);
+CRYSTAL_BENCHMARK("copy_40/crystal::inline_string", Copy<Inline, kLongParts>);
+CRYSTAL_BENCHMARK("copy_40/std::string", Copy<std::string, kLongParts>);
+CRYSTAL_BENCHMARK("hash_15/crystal::inline_string", Hash<Inline, kParts>);
+CRYSTAL_BENCHMARK("hash_15/std::string", Hash<std::string, kParts>);
+CRYSTAL_BENCHMARK("hash_40/crystal::inline_string", Hash<Inline, kLongParts>);
+CRYSTAL_BENCHMARK("hash_40/std::string", Hash<std::string, kLongParts>);
+CRYSTAL_BENCHMARK("map_lookup_40/crystal::inline_string",
+                  MapLookup<Inline, kLongParts>);
+CRYSTAL_BENCHMARK("map_lookup_40/std::string", MapLookup<std::string, kLongParts>);
@@ -0,0 +1,99 @@
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CrystalBase/interner.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+constexpr size_t kNKeys = 1024;
+
+std::vector<std::string> Keys() {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < kNKeys; ++i) {
+    keys.push_back("component/transform/" + std::to_string(i * 7919));
+  }
+  return keys;
+}
+
+/* Map lookups keyed by interned symbols vs by strings. */
+void MapLookupSymbol(State& state) {
+  crystal::Interner interner;
+  std::vector<crystal::SymbolId> keys;
+  std::unordered_map<crystal::SymbolId, size_t> map;
+  for (const auto& key : Keys()) {
+    keys.push_back(interner.intern(key));
+    map.emplace(keys.back(), keys.size());
+  }
+  state.SetItemsPerIteration(kNKeys);
+  for (auto _ : state) {
+    size_t sum = 0;
+    for (auto key : keys) sum += map.find(key)->second;
+    DoNotOptimize(sum);
+  }
+}
+
+void MapLookupString(State& state) {
+  std::vector<std::string> keys = Keys();
+  std::unordered_map<std::string, size_t> map;
+  for (const auto& key : keys) map.emplace(key, map.size() + 1);
+  state.SetItemsPerIteration(kNKeys);
+  for (auto _ : state) {
+    size_t sum = 0;
+    for (const auto& key : keys) sum += map.find(key)->second;
+    DoNotOptimize(sum);
+  }
+}
+
+/* Equality of two lists of identical keys held in distinct storage. */
+void EqualSymbol(State& state) {
+  crystal::Interner interner;
+  std::vector<crystal::SymbolId> a, b;
+  for (const auto& key : Keys()) a.push_back(interner.intern(key));
+  for (const auto& key : Keys()) b.push_back(interner.intern(key));
+  state.SetItemsPerIteration(kNKeys);
+  for (auto _ : state) {
+    size_t equal = 0;
+    for (size_t i = 0; i < kNKeys; ++i) equal += a[i] == b[i];
+    DoNotOptimize(equal);
+  }
+}
+
+void EqualString(State& state) {
+  std::vector<std::string> a = Keys(), b = Keys();
+  state.SetItemsPerIteration(kNKeys);
+  for (auto _ : state) {
+    size_t equal = 0;
+    for (size_t i = 0; i < kNKeys; ++i) equal += a[i] == b[i];
+    DoNotOptimize(equal);
+  }
+}
+
+/* The cost of turning a string into a symbol (hit). */
+void Intern(State& state) {
+  crystal::Interner interner;
+  std::vector<std::string> keys = Keys();
+  for (const auto& key : keys) interner.intern(key);
+  state.SetItemsPerIteration(kNKeys);
+  for (auto _ : state) {
+    for (const auto& key : keys) DoNotOptimize(interner.intern(key));
+  }
+}
+
+void InternLiteral(State& state) {
+  for (auto _ : state) DoNotOptimize(crystal::intern<"component/transform">());
+}
+
+} // namespace
+
+CRYSTAL_BENCHMARK("map_lookup/crystal::SymbolId", MapLookupSymbol);
+CRYSTAL_BENCHMARK("map_lookup/std::string", MapLookupString);
+CRYSTAL_BENCHMARK("equal/crystal::SymbolId", EqualSymbol);
+CRYSTAL_BENCHMARK("equal/std::string", EqualString);
+CRYSTAL_BENCHMARK("intern/crystal::Interner::intern(hit)", Intern);
+CRYSTAL_BENCHMARK("intern/crystal::intern<literal>", InternLiteral);
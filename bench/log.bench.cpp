@@ -0,0 +1,97 @@
+#include <cstdint>
+#include <cstdio>
+
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+
+#include "CrystalBase/log.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+/* Discards everything, so formatting is all that is measured. */
+class NullBuffer : public std::streambuf {
+ protected:
+  int_type overflow(int_type c) override {
+    return c;
+  }
+  std::streamsize xsputn(const char*, std::streamsize n) override {
+    return n;
+  }
+};
+
+/* Calls per iteration: a batch fits in the buffer, so none is dropped. */
+constexpr uint64_t kBatch = 1024;
+
+/**
+ * The cost seen by the logging thread. Each batch is drained without being
+ * formatted, which only skips over the records.
+ */
+void LogCall(State& state) {
+  crystal::LogBuffer& buffer = crystal::ThreadLogBuffer();
+  state.SetItemsPerIteration(kBatch);
+  for (auto _ : state) {
+    for (uint64_t i = 0; i < kBatch; ++i) {
+      crystal::Log<"request {} took {} us on {}">(i, 12.5, "worker");
+    }
+    buffer.Drain([](const crystal::LogRecord&, const std::byte*) {});
+  }
+}
+
+/* Baseline: formatting on the calling thread. */
+void Snprintf(State& state) {
+  char buf[128];
+  state.SetItemsPerIteration(kBatch);
+  for (auto _ : state) {
+    for (uint64_t i = 0; i < kBatch; ++i) {
+      int n = std::snprintf(buf,
+                            sizeof(buf),
+                            "request %llu took %g us on %s",
+                            static_cast<unsigned long long>(i),
+                            12.5,
+                            "worker");
+      DoNotOptimize(n);
+      DoNotOptimize(buf);
+    }
+  }
+}
+
+void Ostringstream(State& state) {
+  std::ostringstream os;
+  state.SetItemsPerIteration(kBatch);
+  for (auto _ : state) {
+    for (uint64_t i = 0; i < kBatch; ++i) {
+      os.str({});
+      os << "request " << i << " took " << 12.5 << " us on " << "worker";
+      DoNotOptimize(os);
+    }
+  }
+}
+
+/* The cost moved to the writer: formatting the records of `arg` calls. */
+void FlushRecords(State& state) {
+  NullBuffer null;
+  std::ostream os{ &null };
+  crystal::FlushLogs(os);
+  const int64_t n = state.arg();
+  state.SetItemsPerIteration(n);
+  for (auto _ : state) {
+    for (int64_t i = 0; i < n; ++i) {
+      crystal::Log<"request {} took {} us on {}">(i, 12.5, "worker");
+    }
+    crystal::FlushLogs(os);
+  }
+}
+
+} // namespace
+
+CRYSTAL_BENCHMARK("log_call/crystal::Log", LogCall);
+CRYSTAL_BENCHMARK("log_call/snprintf", Snprintf);
+CRYSTAL_BENCHMARK("log_call/std::ostringstream", Ostringstream);
+CRYSTAL_BENCHMARK_ARGS("log_flush/crystal::FlushLogs",
+                       crystal::bench::Range(1 << 6, 1 << 12, 8),
+                       FlushRecords);
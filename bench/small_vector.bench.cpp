@@ -0,0 +1,73 @@
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CrystalBase/small_vector.h"
+#include "CrystalBase/static_vector.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+/* A short lived collection, the typical request path use. */
+template <typename C>
+void BuildTemporary(State& state) {
+  const int n = static_cast<int>(state.arg());
+  state.SetItemsPerIteration(n);
+  for (auto _ : state) {
+    C c;
+    for (int i = 0; i < n; ++i) c.push_back(i);
+    DoNotOptimize(c.data());
+  }
+}
+
+template <typename C>
+void Copy(State& state) {
+  C src;
+  for (int i = 0; i < 8; ++i) src.push_back(i);
+  for (auto _ : state) {
+    C copy = src;
+    DoNotOptimize(copy.data());
+  }
+}
+
+/* Growth of non trivially copyable, trivially relocatable elements. */
+template <typename C>
+void GrowUniquePtr(State& state) {
+  const int n = static_cast<int>(state.arg());
+  state.SetItemsPerIteration(n);
+  for (auto _ : state) {
+    C c;
+    for (int i = 0; i < n; ++i) c.push_back(std::make_unique<int>(i));
+    DoNotOptimize(c.data());
+  }
+}
+
+const auto kSizes = crystal::bench::Range(4, 64, 4);
+
+} // namespace
+
+CRYSTAL_BENCHMARK_ARGS("build/crystal::small_vector<int,16>",
+                       kSizes,
+                       BuildTemporary<crystal::small_vector<int, 16>>);
+CRYSTAL_BENCHMARK_ARGS("build/crystal::static_vector<int,64>",
+                       kSizes,
+                       BuildTemporary<crystal::static_vector<int, 64>>);
+CRYSTAL_BENCHMARK_ARGS("build/std::vector<int>",
+                       kSizes,
+                       BuildTemporary<std::vector<int>>);
+CRYSTAL_BENCHMARK("copy_8/crystal::small_vector<int,16>",
+                  Copy<crystal::small_vector<int, 16>>);
+CRYSTAL_BENCHMARK("copy_8/crystal::static_vector<int,16>",
+                  Copy<crystal::static_vector<int, 16>>);
+CRYSTAL_BENCHMARK("copy_8/std::vector<int>", Copy<std::vector<int>>);
+CRYSTAL_BENCHMARK_ARGS(
+    "grow_unique_ptr/crystal::small_vector<4>",
+    (crystal::bench::Range(16, 1024, 8)),
+    GrowUniquePtr<crystal::small_vector<std::unique_ptr<int>, 4>>);
+CRYSTAL_BENCHMARK_ARGS("grow_unique_ptr/std::vector",
+                       (crystal::bench::Range(16, 1024, 8)),
+                       GrowUniquePtr<std::vector<std::unique_ptr<int>>>);
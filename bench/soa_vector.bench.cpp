@@ -0,0 +1,132 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CrystalBase/soa_vector.h"
+#include "CrystalBase/stable_vector.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+struct Vec3 {
+  float x, y, z;
+};
+
+/* A typical 48 byte particle; sweeps touch one or two of its fields. */
+struct Particle {
+  Vec3 pos;
+  Vec3 vel;
+  float color[4];
+  float mass;
+  uint32_t id;
+};
+
+using Particles = crystal::soa_vector<crystal::field<"pos", Vec3>,
+                                      crystal::field<"vel", Vec3>,
+                                      crystal::field<"color", std::array<float, 4>>,
+                                      crystal::field<"mass", float>,
+                                      crystal::field<"id", uint32_t>>;
+
+Particle MakeParticle(size_t i) {
+  float f = static_cast<float>(i);
+  return { { f, f, f }, { 1, 2, 3 }, { 1, 1, 1, 1 }, 1.0f, static_cast<uint32_t>(i) };
+}
+
+/* Single field: relax every mass towards 1 (kept clear of denormals). */
+void MassAos(State& state) {
+  std::vector<Particle> particles;
+  for (int64_t i = 0; i < state.arg(); ++i) particles.push_back(MakeParticle(i));
+  state.SetItemsPerIteration(state.arg());
+  state.SetBytesPerIteration(state.arg() * sizeof(float));
+  for (auto _ : state) {
+    for (Particle& p : particles) p.mass = p.mass * 0.5f + 0.5f;
+    DoNotOptimize(particles.data());
+  }
+}
+
+void MassStableVector(State& state) {
+  crystal::stable_vector<Particle> particles;
+  for (int64_t i = 0; i < state.arg(); ++i) {
+    (void)particles.push_back(MakeParticle(i));
+  }
+  state.SetItemsPerIteration(state.arg());
+  state.SetBytesPerIteration(state.arg() * sizeof(float));
+  for (auto _ : state) {
+    for (size_t i = 0; i < particles.slot_count(); ++i) {
+      particles[i].mass = particles[i].mass * 0.5f + 0.5f;
+    }
+    DoNotOptimize(&particles);
+  }
+}
+
+void MassSoa(State& state) {
+  Particles particles;
+  for (int64_t i = 0; i < state.arg(); ++i) {
+    Particle p = MakeParticle(i);
+    particles.emplace_back(p.pos,
+                           p.vel,
+                           std::array<float, 4>{ 1, 1, 1, 1 },
+                           p.mass,
+                           p.id);
+  }
+  state.SetItemsPerIteration(state.arg());
+  state.SetBytesPerIteration(state.arg() * sizeof(float));
+  for (auto _ : state) {
+    for (float& mass : particles.get<"mass">()) mass = mass * 0.5f + 0.5f;
+    DoNotOptimize(particles.get<"mass">().data());
+  }
+}
+
+/* Two fields: integrate positions. */
+void IntegrateAos(State& state) {
+  std::vector<Particle> particles;
+  for (int64_t i = 0; i < state.arg(); ++i) particles.push_back(MakeParticle(i));
+  state.SetItemsPerIteration(state.arg());
+  for (auto _ : state) {
+    for (Particle& p : particles) {
+      p.pos.x += p.vel.x * 0.01f;
+      p.pos.y += p.vel.y * 0.01f;
+      p.pos.z += p.vel.z * 0.01f;
+    }
+    DoNotOptimize(particles.data());
+  }
+}
+
+void IntegrateSoa(State& state) {
+  Particles particles;
+  for (int64_t i = 0; i < state.arg(); ++i) {
+    Particle p = MakeParticle(i);
+    particles.emplace_back(p.pos, p.vel, std::array<float, 4>{}, p.mass, p.id);
+  }
+  state.SetItemsPerIteration(state.arg());
+  for (auto _ : state) {
+    auto pos = particles.get<"pos">();
+    auto vel = particles.get<"vel">();
+    for (size_t i = 0; i < pos.size(); ++i) {
+      pos[i].x += vel[i].x * 0.01f;
+      pos[i].y += vel[i].y * 0.01f;
+      pos[i].z += vel[i].z * 0.01f;
+    }
+    DoNotOptimize(pos.data());
+  }
+}
+
+const auto kSizes = crystal::bench::Range(1 << 10, 1 << 20, 32);
+
+} // namespace
+
+CRYSTAL_BENCHMARK_ARGS("sweep_one_field/std::vector<Particle>", kSizes, MassAos);
+CRYSTAL_BENCHMARK_ARGS("sweep_one_field/crystal::stable_vector<Particle>",
+                       kSizes,
+                       MassStableVector);
+CRYSTAL_BENCHMARK_ARGS("sweep_one_field/crystal::soa_vector", kSizes, MassSoa);
+CRYSTAL_BENCHMARK_ARGS("sweep_two_fields/std::vector<Particle>",
+                       kSizes,
+                       IntegrateAos);
+CRYSTAL_BENCHMARK_ARGS("sweep_two_fields/crystal::soa_vector",
+                       kSizes,
+                       IntegrateSoa);
@@ -0,0 +1,135 @@
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "CrystalBase/stable_vector.h"
+#include "CrystalBase/static_stable_vector.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+/* Inline capacity for the largest benchmark size. */
+using StaticSlots = crystal::static_stable_vector<int, 65536>;
+
+/* Adapters so all containers run the same benchmark bodies. */
+size_t Push(crystal::stable_vector<int>& c, int v) {
+  return c.push_back(v);
+}
+size_t Push(std::vector<std::optional<int>>& c, int v) {
+  c.push_back(v);
+  return c.size() - 1;
+}
+size_t Push(StaticSlots& c, int v) {
+  return *c.push_back(v);
+}
+int& Get(crystal::stable_vector<int>& c, size_t idx) {
+  return c[idx];
+}
+int& Get(std::vector<std::optional<int>>& c, size_t idx) {
+  return *c[idx];
+}
+int& Get(StaticSlots& c, size_t idx) {
+  return c[idx];
+}
+template <typename C>
+size_t Insert(C& c, int v) {
+  return c.insert(v);
+}
+size_t Insert(StaticSlots& c, int v) {
+  return *c.insert(v);
+}
+
+/* std baseline for the free list: a vector of optionals plus a free stack. */
+struct OptionalSlots {
+  std::vector<std::optional<int>> slots;
+  std::vector<size_t> free;
+
+  size_t insert(int v) {
+    if (free.empty()) return Push(slots, v);
+    size_t idx = free.back();
+    free.pop_back();
+    slots[idx] = v;
+    return idx;
+  }
+  void erase(size_t idx) {
+    slots[idx].reset();
+    free.push_back(idx);
+  }
+};
+
+template <typename C>
+void PushBack(State& state) {
+  const int n = static_cast<int>(state.arg());
+  state.SetItemsPerIteration(n);
+  for (auto _ : state) {
+    C c;
+    for (int i = 0; i < n; ++i) DoNotOptimize(Push(c, i));
+    DoNotOptimize(c);
+  }
+}
+
+template <typename C>
+void RandomAccess(State& state) {
+  const int n = static_cast<int>(state.arg());
+  C c;
+  for (int i = 0; i < n; ++i) (void)Push(c, i);
+  state.SetItemsPerIteration(n);
+  for (auto _ : state) {
+    long sum = 0;
+    size_t idx = 0;
+    for (int i = 0; i < n; ++i) {
+      idx = (idx + 7919) % n;
+      sum += Get(c, idx);
+    }
+    DoNotOptimize(sum);
+  }
+}
+
+template <typename C>
+void EraseInsertChurn(State& state) {
+  const int n = static_cast<int>(state.arg());
+  C c;
+  std::vector<size_t> ids;
+  for (int i = 0; i < n; ++i) ids.push_back(Insert(c, i));
+  state.SetItemsPerIteration(n);
+  for (auto _ : state) {
+    for (int i = 0; i < n; i += 2) c.erase(ids[i]);
+    for (int i = 0; i < n; i += 2) ids[i] = Insert(c, i);
+    DoNotOptimize(ids.data());
+  }
+}
+
+const auto kSizes = crystal::bench::Range(64, 65536, 32);
+
+} // namespace
+
+CRYSTAL_BENCHMARK_ARGS("push_back/crystal::stable_vector",
+                       kSizes,
+                       PushBack<crystal::stable_vector<int>>);
+CRYSTAL_BENCHMARK_ARGS("push_back/crystal::static_stable_vector",
+                       kSizes,
+                       PushBack<StaticSlots>);
+CRYSTAL_BENCHMARK_ARGS("push_back/std::vector<optional>",
+                       kSizes,
+                       PushBack<std::vector<std::optional<int>>>);
+CRYSTAL_BENCHMARK_ARGS("random_access/crystal::stable_vector",
+                       kSizes,
+                       RandomAccess<crystal::stable_vector<int>>);
+CRYSTAL_BENCHMARK_ARGS("random_access/crystal::static_stable_vector",
+                       kSizes,
+                       RandomAccess<StaticSlots>);
+CRYSTAL_BENCHMARK_ARGS("random_access/std::vector<optional>",
+                       kSizes,
+                       RandomAccess<std::vector<std::optional<int>>>);
+CRYSTAL_BENCHMARK_ARGS("erase_insert/crystal::stable_vector",
+                       kSizes,
+                       EraseInsertChurn<crystal::stable_vector<int>>);
+CRYSTAL_BENCHMARK_ARGS("erase_insert/crystal::static_stable_vector",
+                       kSizes,
+                       EraseInsertChurn<StaticSlots>);
+CRYSTAL_BENCHMARK_ARGS("erase_insert/std::vector<optional>+free stack",
+                       kSizes,
+                       EraseInsertChurn<OptionalSlots>);
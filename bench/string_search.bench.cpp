@@ -0,0 +1,113 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "CrystalBase/string_search.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+constexpr crystal::fixed_string kShort = "needle";
+constexpr crystal::fixed_string kLong = "the quick brown fox jumps over the lazy needle";
+
+/**
+ * `size` bytes of lower case words, with the needles only in the last bytes.
+ *
+ * Cached per size: the largest buffers take a while to build. A random 1 MiB
+ * block is tiled to fill the rest.
+ */
+const std::string& Text(size_t size) {
+  static std::map<size_t, std::string> cache;
+  std::string& text = cache[size];
+  if (!text.empty()) return text;
+
+  static constexpr std::string_view kWords[] = {
+    "the", "of", "and", "to", "in", "is", "that", "for", "it", "as", "was",
+    "with", "be", "by", "on", "not", "he", "this", "are", "or", "his", "from",
+    "at", "which", "but", "have", "an", "had", "they", "you", "were", "their",
+    "one", "all", "we", "can", "her", "has", "there", "been", "if", "more",
+    "when", "will", "would", "who", "so", "no", "need", "needs", "lazy", "fox",
+  };
+  std::mt19937 rng{ 42 };
+  std::string block;
+  while (block.size() < (size_t{ 1 } << 20)) {
+    block += kWords[rng() % std::size(kWords)];
+    block += ' ';
+  }
+  text.reserve(size);
+  while (text.size() < size) text.append(block, 0, std::min(block.size(), size - text.size()));
+
+  const std::string_view tail = kLong;
+  std::copy(tail.begin(), tail.end(), text.end() - tail.size());
+  return text;
+}
+
+template <crystal::fixed_string kPattern>
+void FindCrystal(State& state) {
+  const std::string_view text = Text(state.arg());
+  state.SetBytesPerIteration(text.size());
+  for (auto _ : state) DoNotOptimize(crystal::find<kPattern>(text));
+}
+
+template <crystal::fixed_string kPattern>
+void FindStd(State& state) {
+  const std::string_view text = Text(state.arg());
+  state.SetBytesPerIteration(text.size());
+  for (auto _ : state) DoNotOptimize(text.find(std::string_view{ kPattern }));
+}
+
+template <crystal::fixed_string kPattern>
+void FindMemmem(State& state) {
+  const std::string_view text = Text(state.arg());
+  const std::string_view pattern = kPattern;
+  state.SetBytesPerIteration(text.size());
+  for (auto _ : state) {
+    DoNotOptimize(memmem(text.data(), text.size(), pattern.data(), pattern.size()));
+  }
+}
+
+/* Three patterns, the last one only near the end of the text. */
+void FindAnyCrystal(State& state) {
+  const std::string_view text = Text(state.arg());
+  state.SetBytesPerIteration(text.size());
+  for (auto _ : state) {
+    DoNotOptimize(crystal::find_any<"zebra", "quixotic", "lazy needle">(text));
+  }
+}
+
+void FindAnyStd(State& state) {
+  const std::string_view text = Text(state.arg());
+  state.SetBytesPerIteration(text.size());
+  for (auto _ : state) {
+    size_t pos = std::min({ text.find("zebra"),
+                            text.find("quixotic"),
+                            text.find("lazy needle") });
+    DoNotOptimize(pos);
+  }
+}
+
+const auto kSizes = crystal::bench::Range(1 << 20, 1 << 30, 32);
+
+} // namespace
+
+CRYSTAL_BENCHMARK_ARGS("find_short/crystal::find", kSizes, FindCrystal<kShort>);
+CRYSTAL_BENCHMARK_ARGS("find_short/std::string_view::find",
+                       kSizes,
+                       FindStd<kShort>);
+CRYSTAL_BENCHMARK_ARGS("find_short/memmem", kSizes, FindMemmem<kShort>);
+CRYSTAL_BENCHMARK_ARGS("find_long/crystal::find", kSizes, FindCrystal<kLong>);
+CRYSTAL_BENCHMARK_ARGS("find_long/std::string_view::find",
+                       kSizes,
+                       FindStd<kLong>);
+CRYSTAL_BENCHMARK_ARGS("find_long/memmem", kSizes, FindMemmem<kLong>);
+CRYSTAL_BENCHMARK_ARGS("find_any/crystal::find_any", kSizes, FindAnyCrystal);
+CRYSTAL_BENCHMARK_ARGS("find_any/std::string_view::find", kSizes, FindAnyStd);
@@ -0,0 +1,126 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+#include <thread>
+#include <vector>
+
+#include "CrystalBase/thread_pool.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+constexpr size_t kN = 1 << 20;
+constexpr size_t kGrain = 1024;
+
+/* A few dependent flops per element, so the loop is not memory bound. */
+inline float Work(float x, int rounds = 16) {
+  for (int i = 0; i < rounds; ++i) x = std::sqrt(x * 1.0001f + 1.0f);
+  return x;
+}
+/* Work growing along the range: a static split leaves threads idle. */
+inline int Rounds(size_t i) {
+  return 1 + static_cast<int>(i * 64 / kN);
+}
+
+/* Pools sized `threads` wide: the caller plus `threads - 1` workers. */
+crystal::ThreadPool MakePool(const State& state) {
+  return crystal::ThreadPool{ { .num_threads = static_cast<size_t>(state.arg() - 1) } };
+}
+
+/* The hand rolled baseline: one contiguous slice per thread. */
+template <typename Op>
+void StaticFanOut(size_t threads, size_t n, Op op) {
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < threads; ++t) {
+    pool.emplace_back([&, t] {
+      for (size_t i = n * t / threads; i < n * (t + 1) / threads; ++i) op(i);
+    });
+  }
+  for (size_t i = 0; i < n / threads; ++i) op(i);
+  for (std::thread& thread : pool) thread.join();
+}
+
+void ForPool(State& state) {
+  auto pool = MakePool(state);
+  std::vector<float> data(kN, 1.0f);
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    pool.parallel_for(data, kGrain, [](float& x) { x = Work(x); });
+    DoNotOptimize(data.data());
+  }
+}
+
+void ForStdThread(State& state) {
+  std::vector<float> data(kN, 1.0f);
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    StaticFanOut(state.arg(), kN, [&](size_t i) { data[i] = Work(data[i]); });
+    DoNotOptimize(data.data());
+  }
+}
+
+void ImbalancedPool(State& state) {
+  auto pool = MakePool(state);
+  std::vector<float> data(kN, 1.0f);
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    pool.parallel_for(std::views::iota(size_t{ 0 }, kN), kGrain, [&](size_t i) {
+      data[i] = Work(data[i], Rounds(i));
+    });
+    DoNotOptimize(data.data());
+  }
+}
+
+void ImbalancedStdThread(State& state) {
+  std::vector<float> data(kN, 1.0f);
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    StaticFanOut(state.arg(), kN, [&](size_t i) {
+      data[i] = Work(data[i], Rounds(i));
+    });
+    DoNotOptimize(data.data());
+  }
+}
+
+void ReducePool(State& state) {
+  auto pool = MakePool(state);
+  std::vector<float> data(kN, 1.0f);
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    double sum = pool.parallel_reduce(data,
+                                      kGrain,
+                                      0.0,
+                                      std::plus<>{},
+                                      [](float x) { return double{ Work(x) }; });
+    DoNotOptimize(sum);
+  }
+}
+
+/* The fixed cost of a small loop: split, steal and join. */
+void SmallLoopPool(State& state) {
+  auto pool = MakePool(state);
+  std::vector<uint32_t> data(1024);
+  for (auto _ : state) {
+    pool.parallel_for(data, 64, [](uint32_t& x) { ++x; });
+    DoNotOptimize(data.data());
+  }
+}
+
+const auto kThreads = crystal::bench::ThreadCounts();
+
+} // namespace
+
+CRYSTAL_BENCHMARK_ARGS("parallel_for/crystal::ThreadPool", kThreads, ForPool);
+CRYSTAL_BENCHMARK_ARGS("parallel_for/std::thread", kThreads, ForStdThread);
+CRYSTAL_BENCHMARK_ARGS("parallel_for_imbalanced/crystal::ThreadPool",
+                       kThreads,
+                       ImbalancedPool);
+CRYSTAL_BENCHMARK_ARGS("parallel_for_imbalanced/std::thread",
+                       kThreads,
+                       ImbalancedStdThread);
+CRYSTAL_BENCHMARK_ARGS("parallel_reduce/crystal::ThreadPool", kThreads, ReducePool);
+CRYSTAL_BENCHMARK_ARGS("small_loop/crystal::ThreadPool", kThreads, SmallLoopPool);
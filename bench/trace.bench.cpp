@@ -0,0 +1,44 @@
+#include <chrono>
+#include <sstream>
+
+#define CRYSTAL_ENABLE_TRACING 1
+#include "CrystalBase/trace.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+void TraceScope(State& state) {
+  for (auto _ : state) {
+    CRYSTAL_TRACE_SCOPE("bench_span");
+    crystal::bench::ClobberMemory();
+  }
+  std::ostringstream os; // drop the recorded spans
+  crystal::WriteChromeTrace(os);
+}
+
+/* Baseline: the two clock reads a span needs, through std::chrono. */
+void SteadyClockPair(State& state) {
+  for (auto _ : state) {
+    auto begin = std::chrono::steady_clock::now();
+    auto end = std::chrono::steady_clock::now();
+    DoNotOptimize(begin);
+    DoNotOptimize(end);
+  }
+}
+
+/* The floor of a span: its two timestamps. */
+void TraceClockPair(State& state) {
+  for (auto _ : state) {
+    DoNotOptimize(crystal::TraceClock::Now());
+    DoNotOptimize(crystal::TraceClock::Now());
+  }
+}
+
+} // namespace
+
+CRYSTAL_BENCHMARK("trace_span/CRYSTAL_TRACE_SCOPE", TraceScope);
+CRYSTAL_BENCHMARK("trace_span/steady_clock::now()x2", SteadyClockPair);
+CRYSTAL_BENCHMARK("trace_span/TraceClock::Now()x2", TraceClockPair);
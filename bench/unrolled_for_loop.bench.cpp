@@ -0,0 +1,41 @@
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "CrystalBase/unrolled_for_loop.h"
+#include "bench.h"
+
+namespace {
+
+using crystal::bench::DoNotOptimize;
+using crystal::bench::State;
+
+template <size_t kN>
+void Unrolled(State& state) {
+  uint32_t acc = 1;
+  auto op = [&acc]() { acc = std::rotl(acc, 5) ^ (acc + 0x9e3779b9u); };
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    crystal::UnrolledForLoop<decltype(op), kN>(op);
+    DoNotOptimize(acc);
+  }
+}
+
+template <size_t kN>
+void PlainLoop(State& state) {
+  uint32_t acc = 1;
+  size_t n = kN;
+  state.SetItemsPerIteration(kN);
+  for (auto _ : state) {
+    DoNotOptimize(n); // keep the trip count opaque
+    for (size_t i = 0; i < n; ++i) acc = std::rotl(acc, 5) ^ (acc + 0x9e3779b9u);
+    DoNotOptimize(acc);
+  }
+}
+
+} // namespace
+
+CRYSTAL_BENCHMARK("loop_8/crystal::UnrolledForLoop", Unrolled<8>);
+CRYSTAL_BENCHMARK("loop_8/for", PlainLoop<8>);
+CRYSTAL_BENCHMARK("loop_64/crystal::UnrolledForLoop", Unrolled<64>);
+CRYSTAL_BENCHMARK("loop_64/for", PlainLoop<64>);
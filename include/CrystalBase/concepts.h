@@ -5,6 +5,7 @@
 
 #include <array>
 #include <concepts>
+#include <memory>
 #include <type_traits>
 
 namespace crystal {
@@ -22,6 +23,26 @@ template <typename T, size_t N>
 struct is_std_array<std::array<T, N>> : std::true_type {};
 template <typename T>
 concept is_std_array_v = is_std_array<T>::value;
+
+/**
+ * Whether moving a `T` to new storage and destroying the source is equivalent
+ * to copying its bytes. Containers relocate such types with `memcpy`.
+ *
+ * Specialize for types that are not trivially copyable but still relocatable
+ * (e.g. types holding an owning pointer).
+ */
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+template <typename T>
+concept is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+/**
+ * A `unique_ptr` with the default deleter is a single owning pointer: the
+ * moved from source is null and destroying it does nothing, so copying its
+ * bytes and forgetting the source is the same as moving it.
+ */
+template <typename T>
+struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
 } // namespace crystal
 
 #endif
\ No newline at end of file
@@ -0,0 +1,571 @@
+#ifndef CRYSTALBASE_CONCURRENT_QUEUE_H_
+#define CRYSTALBASE_CONCURRENT_QUEUE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace crystal {
+
+namespace queue_detail {
+
+/* Producer and consumer state live on separate lines of this size. */
+inline constexpr size_t kCacheLine = 64;
+
+/* Uninitialized storage for one item. */
+template <typename T>
+struct Cell {
+  T* get() {
+    return std::launder(reinterpret_cast<T*>(bytes));
+  }
+
+  alignas(T) std::byte bytes[sizeof(T)];
+};
+
+/**
+ * Whether `HeavyFence` is available, registering the process for it once.
+ */
+inline bool HasHeavyFence() {
+#if defined(__linux__)
+  static const bool registered =
+      syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0)
+      == 0;
+  return registered;
+#else
+  return false;
+#endif
+}
+/**
+ * A full fence on every running thread of the process, so that the other
+ * party of a handshake only needs a compiler fence.
+ *
+ * @note Only call it when `HasHeavyFence()`.
+ */
+inline void HeavyFence() {
+#if defined(__linux__)
+  syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+#endif
+}
+
+/* Spin loop hint. */
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#else
+  std::this_thread::yield();
+#endif
+}
+
+/**
+ * The threads of one side of a queue sleeping until the other side moves.
+ *
+ * A sleeper reads the epoch, raises the flag and checks its condition once
+ * more before it waits. The other side, after every change, clears a raised
+ * flag and bumps the epoch. The fences pair up: either the sleeper sees the
+ * change or the waker sees the flag. Clearing the flag spares further
+ * notifies while a woken sleeper has yet to run.
+ *
+ * Changes are frequent and sleeps rare, so where the system allows the
+ * sleeper pays for both fences with a process wide one and the waker's
+ * fence is reduced to a compiler fence: a push or pop with nobody asleep
+ * costs one relaxed load of the flag. Before paying for it, a sleeper spins
+ * and then yields for a bounded number of rounds, which is enough for the
+ * other side to catch up under light contention.
+ */
+class alignas(kCacheLine) Sleepers {
+ public:
+  static constexpr int kSpins = 64;
+  static constexpr int kYields = 16;
+
+  /* Sleep unless `ready()`, which is checked after announcing ourselves. */
+  template <typename Ready>
+  void Sleep(Ready ready) {
+    for (int i = 0; i < kSpins + kYields; ++i) {
+      if (ready()) return;
+      if (i < kSpins) {
+        CpuRelax();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    const uint32_t epoch = epoch_.load(std::memory_order_acquire);
+    flag_.store(true, std::memory_order_relaxed);
+    if (HasHeavyFence()) {
+      HeavyFence();
+    } else {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    if (!ready()) epoch_.wait(epoch, std::memory_order_acquire);
+  }
+  /* Wake every sleeper, after a change they may wait for. */
+  void Wake() {
+    if (HasHeavyFence()) {
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+    } else {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    if (flag_.load(std::memory_order_relaxed)
+        && flag_.exchange(false, std::memory_order_relaxed)) {
+      epoch_.fetch_add(1, std::memory_order_release);
+      epoch_.notify_all();
+    }
+  }
+
+ private:
+  std::atomic<bool> flag_ = false;
+  std::atomic<uint32_t> epoch_ = 0;
+};
+
+} // namespace queue_detail
+
+/**
+ * A bounded lock free queue for one producer and one consumer thread.
+ *
+ * A ring of `kCapacity` inline slots indexed by two ever growing positions:
+ * the producer owns `tail`, the consumer owns `head`. Each side keeps its
+ * position on its own cache line next to a cached copy of the other side's,
+ * so the other line is only read when the cache says the ring is full (or
+ * empty).
+ *
+ * The `try_` members never block. `push`, `emplace` and `pop` sleep on
+ * `std::atomic::wait` while the queue is full or empty. `try_push_n` and
+ * `try_pop_n` move a whole run of items with a single publishing store.
+ *
+ * The slots are stored inline; allocate large queues on the heap.
+ *
+ * @tparam T Item type.
+ * @tparam kCapacity Number of slots, a power of two.
+ */
+template <typename T, size_t kCapacity>
+class spsc_queue {
+  static_assert(std::has_single_bit(kCapacity),
+                "spsc_queue capacity must be a power of two.");
+  static constexpr size_t kMask = kCapacity - 1;
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+
+  /* Constructors */
+  spsc_queue() = default;
+  spsc_queue(const spsc_queue&) = delete;
+  spsc_queue& operator=(const spsc_queue&) = delete;
+
+  /* Destructor */
+  ~spsc_queue() {
+    const size_t tail = producer_.tail.load(std::memory_order_acquire);
+    for (size_t i = consumer_.head.load(std::memory_order_relaxed); i != tail; ++i) {
+      std::destroy_at(cells_[i & kMask].get());
+    }
+  }
+
+  /* Capacity, a snapshot under concurrency. */
+  static constexpr size_t capacity() {
+    return kCapacity;
+  }
+  size_t size() const {
+    const size_t head = consumer_.head.load(std::memory_order_acquire);
+    return producer_.tail.load(std::memory_order_acquire) - head;
+  }
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /* Producer */
+  bool try_push(const T& item) {
+    return try_emplace(item);
+  }
+  bool try_push(T&& item) {
+    return try_emplace(std::move(item));
+  }
+  /* Construct an item in place, false if the queue is full. */
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    const size_t tail = producer_.tail.load(std::memory_order_relaxed);
+    if (Free(tail, 1) == 0) return false;
+    std::construct_at(cells_[tail & kMask].get(), std::forward<Args>(args)...);
+    Publish(tail + 1);
+    return true;
+  }
+  /**
+   * Push up to `n` items read from `first`.
+   *
+   * @return The number of items pushed, as many as fit.
+   */
+  template <std::input_iterator Iter>
+  size_t try_push_n(Iter first, size_t n) {
+    const size_t tail = producer_.tail.load(std::memory_order_relaxed);
+    const size_t count = std::min(n, Free(tail, n));
+    size_t i = 0;
+    try {
+      for (; i < count; ++i, ++first) {
+        std::construct_at(cells_[(tail + i) & kMask].get(), *first);
+      }
+    } catch (...) {
+      if (i != 0) Publish(tail + i);
+      throw;
+    }
+    if (count != 0) Publish(tail + count);
+    return count;
+  }
+  /* Push, sleeping while the queue is full. */
+  void push(const T& item) {
+    emplace(item);
+  }
+  void push(T&& item) {
+    emplace(std::move(item));
+  }
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    /* The arguments are only consumed by the attempt that succeeds. */
+    while (!try_emplace(std::forward<Args>(args)...)) {
+      not_full_.Sleep([&] {
+        return Free(producer_.tail.load(std::memory_order_relaxed), 1) != 0;
+      });
+    }
+  }
+
+  /* Consumer */
+  std::optional<T> try_pop() {
+    const size_t head = consumer_.head.load(std::memory_order_relaxed);
+    if (Ready(head, 1) == 0) return std::nullopt;
+    T* item = cells_[head & kMask].get();
+    std::optional<T> out{ std::move(*item) };
+    std::destroy_at(item);
+    Release(head + 1);
+    return out;
+  }
+  /**
+   * Pop up to `n` items, assigning them to `*out++`.
+   *
+   * @return The number of items popped, as many as are ready.
+   */
+  template <typename Out>
+  size_t try_pop_n(Out out, size_t n) {
+    const size_t head = consumer_.head.load(std::memory_order_relaxed);
+    const size_t count = std::min(n, Ready(head, n));
+    size_t i = 0;
+    try {
+      for (; i < count; ++i) {
+        T* item = cells_[(head + i) & kMask].get();
+        *out = std::move(*item);
+        ++out;
+        std::destroy_at(item);
+      }
+    } catch (...) {
+      if (i != 0) Release(head + i);
+      throw;
+    }
+    if (count != 0) Release(head + count);
+    return count;
+  }
+  /* Pop, sleeping while the queue is empty. */
+  T pop() {
+    while (true) {
+      if (std::optional<T> item = try_pop()) return std::move(*item);
+      not_empty_.Sleep([&] {
+        return Ready(consumer_.head.load(std::memory_order_relaxed), 1) != 0;
+      });
+    }
+  }
+
+ private:
+  /* Free slots from `tail` on, at least `want` if the cache allows. */
+  size_t Free(size_t tail, size_t want) {
+    if (kCapacity - (tail - producer_.cached_head) < want) {
+      producer_.cached_head = consumer_.head.load(std::memory_order_acquire);
+    }
+    return kCapacity - (tail - producer_.cached_head);
+  }
+  /* Ready items from `head` on, at least `want` if the cache allows. */
+  size_t Ready(size_t head, size_t want) {
+    if (consumer_.cached_tail - head < want) {
+      consumer_.cached_tail = producer_.tail.load(std::memory_order_acquire);
+    }
+    return consumer_.cached_tail - head;
+  }
+
+  void Publish(size_t tail) {
+    producer_.tail.store(tail, std::memory_order_release);
+    not_empty_.Wake();
+  }
+  void Release(size_t head) {
+    consumer_.head.store(head, std::memory_order_release);
+    not_full_.Wake();
+  }
+
+  struct alignas(queue_detail::kCacheLine) Producer {
+    std::atomic<size_t> tail = 0;
+    size_t cached_head = 0;
+  };
+  struct alignas(queue_detail::kCacheLine) Consumer {
+    std::atomic<size_t> head = 0;
+    size_t cached_tail = 0;
+  };
+
+  /* Variables */
+  Producer producer_;
+  Consumer consumer_;
+  queue_detail::Sleepers not_full_;
+  queue_detail::Sleepers not_empty_;
+  alignas(queue_detail::kCacheLine)
+      std::array<queue_detail::Cell<T>, kCapacity> cells_;
+};
+
+/**
+ * A bounded lock free queue for any number of producer and consumer threads.
+ *
+ * Dmitry Vyukov's ring: every slot carries a sequence number telling which
+ * lap of which side may use it next. Producers claim positions by CAS on
+ * `tail`, consumers on `head`, and hand the slot over by bumping its
+ * sequence, so the two sides only meet on the slots themselves.
+ *
+ * The `try_` members never block. `push`, `emplace` and `pop` sleep on
+ * `std::atomic::wait` while the queue is full or empty. `try_push_n` and
+ * `try_pop_n` claim a run of consecutive slots with a single CAS.
+ *
+ * A claimed slot must be filled, so items are moved in without throwing:
+ * `try_emplace` with a throwing constructor builds the item before claiming,
+ * and `try_push_n` requires a non throwing conversion (pass move iterators).
+ *
+ * @tparam T Item type, nothrow move constructible.
+ * @tparam kCapacity Number of slots, a power of two.
+ */
+template <typename T, size_t kCapacity>
+class mpmc_queue {
+  static_assert(kCapacity >= 2 && std::has_single_bit(kCapacity),
+                "mpmc_queue capacity must be a power of two, at least 2.");
+  static_assert(std::is_nothrow_move_constructible_v<T>,
+                "mpmc_queue items must be nothrow move constructible.");
+  static constexpr size_t kMask = kCapacity - 1;
+
+  /* The slot at `pos` is free for the producer of `pos` when its sequence
+   * reads `pos + kPush`, ready for the consumer of `pos` at `pos + kPop`, and
+   * free again for the producer one lap later, at `pos + kLap`. */
+  static constexpr size_t kPush = 0;
+  static constexpr size_t kPop = 1;
+  static constexpr size_t kLap = kCapacity;
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+
+  /* Constructors */
+  mpmc_queue() {
+    for (size_t i = 0; i < kCapacity; ++i) {
+      slots_[i].sequence.store(i + kPush, std::memory_order_relaxed);
+    }
+  }
+  mpmc_queue(const mpmc_queue&) = delete;
+  mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+  /* Destructor */
+  ~mpmc_queue() {
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    for (size_t i = head_.load(std::memory_order_relaxed); i != tail; ++i) {
+      std::destroy_at(slots_[i & kMask].cell.get());
+    }
+  }
+
+  /* Capacity, a snapshot under concurrency. */
+  static constexpr size_t capacity() {
+    return kCapacity;
+  }
+  size_t size() const {
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    return std::max(static_cast<ptrdiff_t>(tail - head), ptrdiff_t{ 0 });
+  }
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /* Producer */
+  bool try_push(const T& item) {
+    return try_emplace(item);
+  }
+  bool try_push(T&& item) {
+    return try_emplace(std::move(item));
+  }
+  /* Construct an item in place, false if the queue is full. */
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    if constexpr (std::is_nothrow_constructible_v<T, Args...>) {
+      const auto [pos, n] = Claim<kPush>(tail_, 1);
+      if (n == 0) return false;
+      std::construct_at(slots_[pos & kMask].cell.get(), std::forward<Args>(args)...);
+      HandOver<kPop>(pos, 1);
+      return true;
+    } else {
+      return try_emplace(T(std::forward<Args>(args)...));
+    }
+  }
+  /**
+   * Push up to `n` items read from `first`.
+   *
+   * @return The number of items pushed, as many consecutive free slots as
+   * could be claimed at once.
+   */
+  template <std::input_iterator Iter>
+  size_t try_push_n(Iter first, size_t n) {
+    static_assert(std::is_nothrow_constructible_v<T, std::iter_reference_t<Iter>>,
+                  "mpmc_queue batches must not throw, pass move iterators.");
+    const auto [pos, claimed] = Claim<kPush>(tail_, n);
+    for (size_t i = 0; i < claimed; ++i, ++first) {
+      std::construct_at(slots_[(pos + i) & kMask].cell.get(), *first);
+    }
+    HandOver<kPop>(pos, claimed);
+    return claimed;
+  }
+  /* Push, sleeping while the queue is full. */
+  void push(const T& item) {
+    emplace(item);
+  }
+  void push(T&& item) {
+    emplace(std::move(item));
+  }
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    if constexpr (std::is_nothrow_constructible_v<T, Args...>) {
+      /* The arguments are only consumed by the attempt that succeeds. */
+      while (!try_emplace(std::forward<Args>(args)...)) Wait<kPush>(tail_);
+    } else {
+      emplace(T(std::forward<Args>(args)...));
+    }
+  }
+
+  /* Consumer */
+  std::optional<T> try_pop() {
+    const auto [pos, n] = Claim<kPop>(head_, 1);
+    if (n == 0) return std::nullopt;
+    T* item = slots_[pos & kMask].cell.get();
+    std::optional<T> out{ std::move(*item) };
+    std::destroy_at(item);
+    HandOver<kLap>(pos, 1);
+    return out;
+  }
+  /**
+   * Pop up to `n` items, assigning them to `*out++`.
+   *
+   * @return The number of items popped, as many consecutive ready slots as
+   * could be claimed at once.
+   */
+  template <typename Out>
+  size_t try_pop_n(Out out, size_t n) {
+    const auto [pos, claimed] = Claim<kPop>(head_, n);
+    size_t i = 0;
+    try {
+      for (; i < claimed; ++i) {
+        T* item = slots_[(pos + i) & kMask].cell.get();
+        *out = std::move(*item);
+        ++out;
+        std::destroy_at(item);
+      }
+    } catch (...) {
+      /* The claimed slots must still be freed, the rest of the run is lost. */
+      for (; i < claimed; ++i) std::destroy_at(slots_[(pos + i) & kMask].cell.get());
+      HandOver<kLap>(pos, claimed);
+      throw;
+    }
+    HandOver<kLap>(pos, claimed);
+    return claimed;
+  }
+  /* Pop, sleeping while the queue is empty. */
+  T pop() {
+    while (true) {
+      if (std::optional<T> item = try_pop()) return std::move(*item);
+      Wait<kPop>(head_);
+    }
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    queue_detail::Cell<T> cell;
+  };
+
+  /**
+   * Claim up to `n` consecutive slots from `index` on.
+   *
+   * @return The first claimed position and the number of slots claimed, 0 if
+   * the queue is full (for producers) or empty (for consumers).
+   */
+  template <size_t kOffset>
+  std::pair<size_t, size_t> Claim(std::atomic<size_t>& index, size_t n) {
+    const size_t want = std::min(n, kCapacity);
+    size_t pos = index.load(std::memory_order_relaxed);
+    while (want != 0) {
+      size_t k = 0;
+      ptrdiff_t diff = 0;
+      for (; k < want; ++k) {
+        const Slot& slot = slots_[(pos + k) & kMask];
+        const size_t seq = slot.sequence.load(std::memory_order_acquire);
+        diff = static_cast<ptrdiff_t>(seq - (pos + k + kOffset));
+        if (diff != 0) break;
+      }
+      if (k == 0) {
+        if (diff < 0) break; // full or empty
+        pos = index.load(std::memory_order_relaxed); // lost a race, catch up
+        continue;
+      }
+      if (index.compare_exchange_weak(pos,
+                                      pos + k,
+                                      std::memory_order_relaxed,
+                                      std::memory_order_relaxed)) {
+        return { pos, k };
+      }
+    }
+    return { pos, 0 };
+  }
+
+  /* Pass slots [pos, pos + n) on to the other side, `kAhead` positions on. */
+  template <size_t kAhead>
+  void HandOver(size_t pos, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      slots_[(pos + i) & kMask].sequence.store(pos + i + kAhead,
+                                               std::memory_order_release);
+    }
+    if (n != 0) (kAhead == kPop ? not_empty_ : not_full_).Wake();
+  }
+
+  /* Sleep until the slot at `index` may have been handed over to us. */
+  template <size_t kOffset>
+  void Wait(const std::atomic<size_t>& index) {
+    (kOffset == kPush ? not_full_ : not_empty_).Sleep([&] {
+      const size_t pos = index.load(std::memory_order_relaxed);
+      const Slot& slot = slots_[pos & kMask];
+      const size_t seq = slot.sequence.load(std::memory_order_relaxed);
+      return static_cast<ptrdiff_t>(seq - (pos + kOffset)) >= 0;
+    });
+  }
+
+  /* Variables */
+  alignas(queue_detail::kCacheLine) std::atomic<size_t> tail_ = 0;
+  alignas(queue_detail::kCacheLine) std::atomic<size_t> head_ = 0;
+  queue_detail::Sleepers not_full_;
+  queue_detail::Sleepers not_empty_;
+  alignas(queue_detail::kCacheLine) std::array<Slot, kCapacity> slots_;
+};
+
+} // namespace crystal
+
+#endif
@@ -1,6 +1,11 @@
 #ifndef CRYSTALBASE_CONTAINERS_H_
 #define CRYSTALBASE_CONTAINERS_H_
 
+#include "CrystalBase/flat_hash_map.h"
+#include "CrystalBase/small_vector.h"
+#include "CrystalBase/soa_vector.h"
 #include "CrystalBase/stable_vector.h"
+#include "CrystalBase/static_stable_vector.h"
+#include "CrystalBase/static_vector.h"
 
 #endif
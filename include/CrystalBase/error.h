@@ -1,14 +1,160 @@
 #ifndef CRYSTALBASE_ERROR_H_
 #define CRYSTALBASE_ERROR_H_
 
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "fixed_string.h"
 
 namespace crystal {
 
-struct Error {
-  std::string msg;
+/* Coarse classification of an error, independent of its numeric code. */
+enum class ErrorCategory : uint8_t {
+  kGeneric,
+  kSystem, // code is an `errno` value
+  kIo,
+  kParse,
+  kCapacity,
 };
 
+/* Static storage for `fixed_string` messages referenced by `Error`. */
+template <fixed_string kStr>
+inline constexpr auto static_string_v = kStr;
+
+class Error;
+
+/**
+ * A message with static storage duration.
+ *
+ * The constructor being `consteval` guarantees the pointer refers to static
+ * storage (e.g. a string literal), so it can be kept without copying.
+ */
+struct StaticMessage {
+  consteval StaticMessage(const char* str) : // NOLINT: implicit from literals
+      data{ str }, size{ std::char_traits<char>::length(str) } {
+  }
+
+  const char* data;
+  size_t size;
+
+ private:
+  friend class Error;
+  constexpr StaticMessage(const char* str, size_t len) : data{ str }, size{ len } {
+  }
+};
+
+/**
+ * An allocation free error.
+ *
+ * An error is made of a numeric code, a category and a message. The message
+ * either refers to a string with static storage duration (a string literal or
+ * a `fixed_string` template argument) or is copied into a small inline buffer
+ * of `kInlineCapacity` chars, in which case it is truncated.
+ *
+ * The type is trivially copyable and 32 bytes large, so returning it through
+ * `std::expected` never touches the heap.
+ *
+ * Equality compares the category and the code only: two errors differing in
+ * nothing but their message are equal.
+ */
+class Error {
+ public:
+  static constexpr size_t kInlineCapacity = 24;
+
+  /* Constructors */
+  /**
+   * Construct an error referring to a static message.
+   *
+   * @param msg A string literal, only its pointer is stored.
+   */
+  constexpr Error(StaticMessage msg, // NOLINT: implicit from string literals
+                  ErrorCategory category = ErrorCategory::kGeneric,
+                  int32_t code = 0) :
+      code_{ code },
+      category_{ category },
+      is_static_{ true },
+      size_{ static_cast<uint16_t>(std::min<size_t>(msg.size, UINT16_MAX)) },
+      static_msg_{ msg.data } {
+  }
+  /**
+   * Construct an error referring to a `fixed_string` message.
+   *
+   * @tparam kMsg The message, stored once in static storage.
+   */
+  template <fixed_string kMsg>
+  static constexpr Error Make(ErrorCategory category = ErrorCategory::kGeneric,
+                              int32_t code = 0) {
+    static_assert(kMsg.size() <= UINT16_MAX, "Error message too long.");
+    constexpr StaticMessage msg{ static_string_v<kMsg>.data_.data(), kMsg.size() };
+    return Error{ msg, category, code };
+  }
+  /**
+   * Construct an error holding a copy of a runtime message.
+   *
+   * @param msg The message. Only the first `kInlineCapacity` chars are kept.
+   */
+  static constexpr Error Inline(std::string_view msg,
+                                ErrorCategory category = ErrorCategory::kGeneric,
+                                int32_t code = 0) {
+    Error err{};
+    err.code_ = code;
+    err.category_ = category;
+    err.is_static_ = false;
+    err.size_ = static_cast<uint16_t>(std::min(msg.size(), kInlineCapacity));
+    std::copy_n(msg.data(), err.size_, err.inline_msg_);
+    return err;
+  }
+
+  /* Accessors */
+  constexpr std::string_view msg() const {
+    return is_static_ ? std::string_view{ static_msg_, size_ }
+                      : std::string_view{ inline_msg_, size_ };
+  }
+  constexpr int32_t code() const {
+    return code_;
+  }
+  constexpr ErrorCategory category() const {
+    return category_;
+  }
+  constexpr bool is_static() const {
+    return is_static_;
+  }
+
+  /* Operators */
+  /* Errors are identified by category and code, the message is ignored. */
+  constexpr bool operator==(const Error& other) const {
+    return category_ == other.category_ && code_ == other.code_;
+  }
+
+ private:
+  constexpr Error() : inline_msg_{} {
+  }
+
+  /* Variables */
+  int32_t code_ = 0;
+  ErrorCategory category_ = ErrorCategory::kGeneric;
+  bool is_static_ = false;
+  uint16_t size_ = 0;
+  union {
+    const char* static_msg_;
+    char inline_msg_[kInlineCapacity];
+  };
+};
+
+static_assert(std::is_trivially_copyable_v<Error>);
+static_assert(sizeof(Error) <= 32);
+
+/* Output to stream. */
+inline std::ostream& operator<<(std::ostream& os, const Error& err) {
+  return os << err.msg();
+}
+
 } // namespace crystal
 
 #endif
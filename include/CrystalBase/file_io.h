@@ -2,6 +2,7 @@
 #define CRYSTALBASE_FILE_IO_H_
 
 #include <cassert>
+#include <cerrno>
 
 #include <filesystem>
 #include <fstream>
@@ -15,7 +16,8 @@ namespace crystal {
 inline std::expected<std::string, Error> ReadFile(std::filesystem::path file_path) {
   assert(file_path.has_filename() && "Input path does not point to a file");
   std::ifstream is{ file_path };
-  if (!is.good()) return std::unexpected(Error{"Cannot open file."});
+  if (!is.good()) return std::unexpected(
+      Error{ "Cannot open file.", ErrorCategory::kSystem, errno });
   std::string content;
   is >> content;
   return content;
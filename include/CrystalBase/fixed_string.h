@@ -6,6 +6,8 @@
 #include <ostream>
 #include <string_view>
 
+#include "hash.h"
+
 namespace crystal {
 
 /**
@@ -63,6 +65,10 @@ struct is_fixed_string<fixed_string<n>> : std::true_type {};
 template <typename T>
 concept is_fixed_string_v = is_fixed_string<T>::value;
 
+/* Hashing, transparent to `std::string_view`. */
+template <size_t kN>
+struct Hash<fixed_string<kN>> : StringHash {};
+
 /* Utility Functions */
 template <auto... fs>
 consteval auto join() {
@@ -110,9 +116,7 @@ namespace std {
 template <size_t n>
 struct hash<crystal::fixed_string<n>> {
   size_t operator()(const crystal::fixed_string<n>& str) const noexcept {
-    size_t hash = 0;
-    for (size_t i = 0; i < n; ++i) hash ^= str[i];
-    return hash;
+    return crystal::HashBytes(str);
   }
 };
 /* Formatting */
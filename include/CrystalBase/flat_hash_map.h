@@ -0,0 +1,1075 @@
+#ifndef CRYSTALBASE_FLAT_HASH_MAP_H_
+#define CRYSTALBASE_FLAT_HASH_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "concepts.h"
+#include "hash.h"
+
+namespace crystal {
+namespace flat_hash_detail {
+
+/*
+ * Control bytes, one per slot. A full slot stores the low 7 bits of its hash
+ * (H2), so the sign bit tells full slots from empty and deleted ones.
+ */
+using ctrl_t = int8_t;
+inline constexpr ctrl_t kEmpty = -128;
+inline constexpr ctrl_t kDeleted = -2;
+inline constexpr size_t kGroupWidth = 16;
+
+constexpr bool IsFull(ctrl_t ctrl) {
+  return ctrl >= 0;
+}
+constexpr size_t H1(size_t hash) {
+  return hash >> 7;
+}
+constexpr ctrl_t H2(size_t hash) {
+  return static_cast<ctrl_t>(hash & 0x7f);
+}
+
+/**
+ * The slots of a group matching some condition.
+ *
+ * Each slot owns `1 << kShift` bits of which only the highest may be set.
+ * Iterating yields the matching slot indices in increasing order.
+ */
+template <typename Int, int kShift>
+class BitMask {
+ public:
+  explicit BitMask(Int bits) : bits_{ bits } {
+  }
+
+  explicit operator bool() const {
+    return bits_ != 0;
+  }
+  size_t Lowest() const {
+    return static_cast<size_t>(std::countr_zero(bits_)) >> kShift;
+  }
+
+  /* Iteration */
+  size_t operator*() const {
+    return Lowest();
+  }
+  BitMask& operator++() {
+    bits_ &= bits_ - 1;
+    return *this;
+  }
+  BitMask begin() const {
+    return *this;
+  }
+  BitMask end() const {
+    return BitMask{ 0 };
+  }
+  bool operator==(const BitMask&) const = default;
+
+ private:
+  Int bits_;
+};
+
+/* `kGroupWidth` control bytes, matched all at once. */
+#if defined(__SSE2__)
+class Group {
+ public:
+  using Mask = BitMask<uint32_t, 0>;
+
+  explicit Group(const ctrl_t* ctrl) :
+      ctrl_{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl)) } {
+  }
+
+  Mask Match(ctrl_t h2) const {
+    return Movemask(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_));
+  }
+  Mask MatchEmpty() const {
+    return Movemask(_mm_cmpeq_epi8(_mm_set1_epi8(kEmpty), ctrl_));
+  }
+  Mask MatchEmptyOrDeleted() const {
+    return Movemask(ctrl_);
+  }
+  Mask MatchFull() const {
+    return Mask{ ~static_cast<uint32_t>(_mm_movemask_epi8(ctrl_)) & 0xffff };
+  }
+
+ private:
+  static Mask Movemask(__m128i bytes) {
+    return Mask{ static_cast<uint32_t>(_mm_movemask_epi8(bytes)) };
+  }
+
+  __m128i ctrl_;
+};
+#elif defined(__ARM_NEON)
+class Group {
+ public:
+  /* NEON has no movemask; narrowing leaves a nibble per byte instead. */
+  using Mask = BitMask<uint64_t, 2>;
+
+  explicit Group(const ctrl_t* ctrl) :
+      ctrl_{ vld1q_s8(ctrl) } {
+  }
+
+  Mask Match(ctrl_t h2) const {
+    return Movemask(vceqq_s8(vdupq_n_s8(h2), ctrl_));
+  }
+  Mask MatchEmpty() const {
+    return Movemask(vceqq_s8(vdupq_n_s8(kEmpty), ctrl_));
+  }
+  Mask MatchEmptyOrDeleted() const {
+    return Movemask(vcltzq_s8(ctrl_));
+  }
+  Mask MatchFull() const {
+    return Movemask(vcgezq_s8(ctrl_));
+  }
+
+ private:
+  static Mask Movemask(uint8x16_t bytes) {
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(bytes), 4);
+    return Mask{ vget_lane_u64(vreinterpret_u64_u8(nibbles), 0)
+                 & 0x8888888888888888ull };
+  }
+
+  int8x16_t ctrl_;
+};
+#else
+class Group {
+ public:
+  using Mask = BitMask<uint32_t, 0>;
+
+  explicit Group(const ctrl_t* ctrl) {
+    std::memcpy(ctrl_, ctrl, kGroupWidth);
+  }
+
+  Mask Match(ctrl_t h2) const {
+    return Movemask([h2](ctrl_t c) { return c == h2; });
+  }
+  Mask MatchEmpty() const {
+    return Movemask([](ctrl_t c) { return c == kEmpty; });
+  }
+  Mask MatchEmptyOrDeleted() const {
+    return Movemask([](ctrl_t c) { return !IsFull(c); });
+  }
+  Mask MatchFull() const {
+    return Movemask([](ctrl_t c) { return IsFull(c); });
+  }
+
+ private:
+  template <typename Pred>
+  Mask Movemask(Pred pred) const {
+    uint32_t bits = 0;
+    for (size_t i = 0; i < kGroupWidth; ++i) {
+      bits |= uint32_t{ pred(ctrl_[i]) } << i;
+    }
+    return Mask{ bits };
+  }
+
+  ctrl_t ctrl_[kGroupWidth];
+};
+#endif
+
+/* Triangular probing over the groups; visits every group once. */
+class Probe {
+ public:
+  Probe(size_t hash, size_t capacity) :
+      mask_{ capacity / kGroupWidth - 1 }, group_{ H1(hash) & mask_ } {
+  }
+
+  size_t Offset() const {
+    return group_ * kGroupWidth;
+  }
+  void Next() {
+    group_ = (group_ + ++step_) & mask_;
+  }
+
+ private:
+  size_t mask_;
+  size_t group_;
+  size_t step_ = 0;
+};
+
+/*
+ * The parameter type of lookups: the key type, or any `K` when the table is
+ * transparent. A plain alias (unlike `std::conditional_t`) keeps `K`
+ * deducible.
+ */
+template <bool kTransparent>
+struct KeyArg {
+  template <typename K, typename Key>
+  using type = Key;
+};
+template <>
+struct KeyArg<true> {
+  template <typename K, typename Key>
+  using type = K;
+};
+
+/*
+ * Slot policies: how the table sees its elements.
+ *
+ * `slot_type` is what the slot array holds, `Element` the element in it.
+ * `Relocate` moves an element to an uninitialized slot and ends the source;
+ * it cannot throw when `kNothrowRelocate`.
+ */
+template <typename K>
+struct SetPolicy {
+  using key_type = K;
+  using value_type = K;
+  using slot_type = K;
+
+  static constexpr bool kNothrowRelocate =
+      is_trivially_relocatable_v<K> || std::is_nothrow_move_constructible_v<K>;
+
+  static const K& Key(const value_type& value) {
+    return value;
+  }
+  static value_type& Element(slot_type& slot) {
+    return slot;
+  }
+  static const value_type& Element(const slot_type& slot) {
+    return slot;
+  }
+  template <typename Alloc>
+  static void Relocate(Alloc& alloc, slot_type* src, slot_type* dst) {
+    using traits = std::allocator_traits<Alloc>;
+    if constexpr (is_trivially_relocatable_v<K>) {
+      std::memcpy(static_cast<void*>(dst), src, sizeof(slot_type));
+    } else {
+      traits::construct(alloc, dst, std::move(*src));
+      traits::destroy(alloc, src);
+    }
+  }
+};
+template <typename K, typename V>
+struct MapPolicy {
+  using key_type = K;
+  using value_type = std::pair<const K, V>;
+
+  /*
+   * The element, seen through a pair with a mutable key when relocating so
+   * the key moves instead of being copied. Both pairs share their layout.
+   */
+  union slot_type {
+    slot_type() {
+    }
+    ~slot_type() {
+    }
+
+    value_type value;
+    std::pair<K, V> mutable_value;
+  };
+
+  static constexpr bool kNothrowRelocate =
+      (is_trivially_relocatable_v<K> && is_trivially_relocatable_v<V>)
+      || (std::is_nothrow_move_constructible_v<K>
+          && std::is_nothrow_move_constructible_v<V>);
+
+  static const K& Key(const value_type& value) {
+    return value.first;
+  }
+  static value_type& Element(slot_type& slot) {
+    return slot.value;
+  }
+  static const value_type& Element(const slot_type& slot) {
+    return slot.value;
+  }
+  template <typename Alloc>
+  static void Relocate(Alloc& alloc, slot_type* src, slot_type* dst) {
+    using traits = std::allocator_traits<Alloc>;
+    if constexpr (is_trivially_relocatable_v<K>
+                  && is_trivially_relocatable_v<V>) {
+      std::memcpy(static_cast<void*>(dst), src, sizeof(slot_type));
+    } else {
+      traits::construct(
+          alloc, &dst->mutable_value, std::move(src->mutable_value));
+      traits::destroy(alloc, &src->mutable_value);
+    }
+  }
+};
+
+/**
+ * Open addressing hash table shared by `flat_hash_map` and `flat_hash_set`.
+ *
+ * Elements live directly in a slot array, next to an array of control bytes
+ * holding 7 bits of each element's hash. Lookups probe a group of 16 control
+ * bytes at a time with SIMD compares (SSE2 or NEON, scalar otherwise) and
+ * only compare keys whose hash bits match. The table grows at 7/8 load.
+ */
+template <typename Policy, typename Hasher, typename KeyEqual, typename Alloc>
+class flat_hash_table {
+  using traits = std::allocator_traits<Alloc>;
+  using ctrl_alloc = typename traits::template rebind_alloc<ctrl_t>;
+  using ctrl_traits = std::allocator_traits<ctrl_alloc>;
+  using slot_type = typename Policy::slot_type;
+  using slot_alloc = typename traits::template rebind_alloc<slot_type>;
+  using slot_traits = std::allocator_traits<slot_alloc>;
+
+  static constexpr size_t kNpos = static_cast<size_t>(-1);
+
+  /* Lookups take any key type when both functors are transparent. */
+  static constexpr bool kTransparent = requires {
+    typename Hasher::is_transparent;
+    typename KeyEqual::is_transparent;
+  };
+
+ public:
+  using key_type = typename Policy::key_type;
+  using value_type = typename Policy::value_type;
+  using hasher = Hasher;
+  using key_equal = KeyEqual;
+  using allocator_type = Alloc; // allocator aware type
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+
+ protected:
+  template <typename K>
+  using key_arg = typename KeyArg<kTransparent>::template type<K, key_type>;
+
+ public:
+  template <bool kConst>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = flat_hash_table::value_type;
+    using difference_type = ptrdiff_t;
+    using reference = std::conditional_t<kConst, const value_type&, value_type&>;
+    using pointer = std::conditional_t<kConst, const value_type*, value_type*>;
+
+    Iterator() = default;
+    operator Iterator<true>() const // NOLINT: implicit
+      requires(!kConst)
+    {
+      return { ctrl_, slot_, end_ };
+    }
+
+    reference operator*() const {
+      return Policy::Element(*slot_);
+    }
+    pointer operator->() const {
+      return &Policy::Element(*slot_);
+    }
+    Iterator& operator++() {
+      ++ctrl_;
+      ++slot_;
+      SkipEmpty();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    bool operator==(const Iterator& other) const {
+      return ctrl_ == other.ctrl_;
+    }
+
+   private:
+    friend class flat_hash_table;
+    template <bool>
+    friend class Iterator;
+
+    using SlotPointer =
+        std::conditional_t<kConst, const slot_type*, slot_type*>;
+
+    Iterator(const ctrl_t* ctrl, SlotPointer slot, const ctrl_t* end) :
+        ctrl_{ ctrl }, slot_{ slot }, end_{ end } {
+    }
+
+    /* Advance to the next full slot, a group at a time. */
+    void SkipEmpty() {
+      while (ctrl_ < end_) {
+        auto full = Group{ ctrl_ }.MatchFull();
+        size_t step = full ? full.Lowest()
+                           : std::min<size_t>(kGroupWidth, end_ - ctrl_);
+        ctrl_ += step;
+        slot_ += step;
+        if (full) break;
+      }
+    }
+
+    const ctrl_t* ctrl_ = nullptr;
+    SlotPointer slot_ = nullptr;
+    const ctrl_t* end_ = nullptr;
+  };
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  /* Constructors */
+  flat_hash_table() : flat_hash_table(0) {
+  }
+  explicit flat_hash_table(size_t bucket_count,
+                           const Hasher& hash = {},
+                           const KeyEqual& eq = {},
+                           const allocator_type& allocator = {}) :
+      hash_{ hash }, eq_{ eq }, alloc_{ allocator } {
+    reserve(bucket_count);
+  }
+  explicit flat_hash_table(const allocator_type& allocator) :
+      flat_hash_table(0, {}, {}, allocator) {
+  }
+  flat_hash_table(const flat_hash_table& other) :
+      flat_hash_table(other,
+                      traits::select_on_container_copy_construction(
+                          other.alloc_)) {
+  }
+  flat_hash_table(const flat_hash_table& other,
+                  const allocator_type& allocator) :
+      flat_hash_table(other.size_, other.hash_, other.eq_, allocator) {
+    CopyFrom(other);
+  }
+  flat_hash_table(flat_hash_table&& other) noexcept :
+      hash_{ std::move(other.hash_) },
+      eq_{ std::move(other.eq_) },
+      alloc_{ std::move(other.alloc_) } {
+    Steal(other);
+  }
+  flat_hash_table(flat_hash_table&& other, const allocator_type& allocator) :
+      hash_{ other.hash_ }, eq_{ other.eq_ }, alloc_{ allocator } {
+    StealOrMove(other);
+  }
+
+  /* Assignment Operators */
+  flat_hash_table& operator=(const flat_hash_table& other) {
+    if (this == &other) return *this;
+    if constexpr (traits::propagate_on_container_copy_assignment::value) {
+      if (alloc_ != other.alloc_) {
+        Reset();
+        alloc_ = other.alloc_;
+      }
+    }
+    clear();
+    hash_ = other.hash_;
+    eq_ = other.eq_;
+    reserve(other.size_);
+    CopyFrom(other);
+    return *this;
+  }
+  flat_hash_table& operator=(flat_hash_table&& other) noexcept(
+      traits::propagate_on_container_move_assignment::value
+      || traits::is_always_equal::value) {
+    if (this == &other) return *this;
+    Reset();
+    if constexpr (traits::propagate_on_container_move_assignment::value) {
+      alloc_ = std::move(other.alloc_);
+    }
+    hash_ = std::move(other.hash_);
+    eq_ = std::move(other.eq_);
+    StealOrMove(other);
+    return *this;
+  }
+
+  /* Destructor */
+  ~flat_hash_table() {
+    Reset();
+  }
+
+  allocator_type get_allocator() const {
+    return alloc_;
+  }
+  hasher hash_function() const {
+    return hash_;
+  }
+  key_equal key_eq() const {
+    return eq_;
+  }
+
+  /* Iterators */
+  iterator begin() {
+    iterator it{ ctrl_, slots_, ctrl_ + capacity_ };
+    it.SkipEmpty();
+    return it;
+  }
+  const_iterator begin() const {
+    const_iterator it{ ctrl_, slots_, ctrl_ + capacity_ };
+    it.SkipEmpty();
+    return it;
+  }
+  const_iterator cbegin() const {
+    return begin();
+  }
+  iterator end() {
+    return { ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_ };
+  }
+  const_iterator end() const {
+    return { ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_ };
+  }
+  const_iterator cend() const {
+    return end();
+  }
+
+  /* Capacity */
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  /* The number of slots, full or not. */
+  size_t capacity() const {
+    return capacity_;
+  }
+  size_t bucket_count() const {
+    return capacity_;
+  }
+  float load_factor() const {
+    return capacity_ ? static_cast<float>(size_) / capacity_ : 0.0f;
+  }
+  static constexpr float max_load_factor() {
+    return 0.875f;
+  }
+  /* Make room for `count` elements without rehashing. */
+  void reserve(size_t count) {
+    if (count > MaxLoad(capacity_)) Resize(CapacityFor(count));
+  }
+  /* Rebuild the table for at least `count` elements, dropping tombstones. */
+  void rehash(size_t count) {
+    count = std::max(count, size_);
+    if (count == 0) {
+      Reset();
+    } else {
+      Resize(CapacityFor(count));
+    }
+  }
+
+  /* Lookup */
+  template <typename K = key_type>
+  iterator find(const key_arg<K>& key) {
+    size_t idx = Find(key, Hashed(key));
+    return idx == kNpos ? end() : IteratorAt(idx);
+  }
+  template <typename K = key_type>
+  const_iterator find(const key_arg<K>& key) const {
+    size_t idx = Find(key, Hashed(key));
+    return idx == kNpos ? end() : IteratorAt(idx);
+  }
+  template <typename K = key_type>
+  bool contains(const key_arg<K>& key) const {
+    return Find(key, Hashed(key)) != kNpos;
+  }
+  template <typename K = key_type>
+  size_t count(const key_arg<K>& key) const {
+    return contains(key);
+  }
+
+  /* Modifiers */
+  void clear() {
+    DestroyAll();
+    if (capacity_) std::fill_n(ctrl_, capacity_, kEmpty);
+    size_ = 0;
+    growth_left_ = MaxLoad(capacity_);
+  }
+  iterator erase(const_iterator pos) {
+    size_t idx = pos.ctrl_ - ctrl_;
+    EraseAt(idx);
+    iterator it{ ctrl_ + idx, slots_ + idx, ctrl_ + capacity_ };
+    it.SkipEmpty();
+    return it;
+  }
+  iterator erase(iterator pos) {
+    return erase(const_iterator{ pos });
+  }
+  template <typename K = key_type>
+  size_t erase(const key_arg<K>& key) {
+    size_t idx = Find(key, Hashed(key));
+    if (idx == kNpos) return 0;
+    EraseAt(idx);
+    return 1;
+  }
+  void swap(flat_hash_table& other) noexcept {
+    using std::swap;
+    if constexpr (traits::propagate_on_container_swap::value) {
+      swap(alloc_, other.alloc_);
+    }
+    swap(hash_, other.hash_);
+    swap(eq_, other.eq_);
+    swap(ctrl_, other.ctrl_);
+    swap(slots_, other.slots_);
+    swap(capacity_, other.capacity_);
+    swap(size_, other.size_);
+    swap(growth_left_, other.growth_left_);
+  }
+
+  /* Operators */
+  bool operator==(const flat_hash_table& other) const {
+    if (size_ != other.size_) return false;
+    for (const value_type& value : *this) {
+      auto it = other.find(Policy::Key(value));
+      if (it == other.end() || !(*it == value)) return false;
+    }
+    return true;
+  }
+
+ protected:
+  /**
+   * Insert an element with `key` built from `args`, unless `key` is present.
+   *
+   * The arguments may refer to elements of this table: on growth the new
+   * element is constructed before the old ones move.
+   */
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> EmplaceKey(const K& key, Args&&... args) {
+    size_t hash = Hashed(key);
+    size_t idx = Find(key, hash);
+    if (idx != kNpos) return { IteratorAt(idx), false };
+    if (growth_left_ == 0) [[unlikely]] {
+      idx = GrowAndEmplace(hash, std::forward<Args>(args)...);
+    } else {
+      idx = FindFirstNonFull(ctrl_, capacity_, hash);
+      traits::construct(alloc_, At(idx), std::forward<Args>(args)...);
+      Commit(idx, hash);
+    }
+    return { IteratorAt(idx), true };
+  }
+
+ private:
+  /* The largest size a capacity holds before growing. */
+  static constexpr size_t MaxLoad(size_t capacity) {
+    return capacity - capacity / 8;
+  }
+  static constexpr size_t CapacityFor(size_t count) {
+    size_t capacity = kGroupWidth;
+    while (MaxLoad(capacity) < count) capacity *= 2;
+    return capacity;
+  }
+
+  /* Spread the user hash over all bits, H1 and H2 both need good ones. */
+  template <typename K>
+  size_t Hashed(const K& key) const {
+    return hash_detail::Mix(static_cast<uint64_t>(hash_(key)), hash_detail::kP0);
+  }
+
+  value_type* At(size_t idx) {
+    return &Policy::Element(slots_[idx]);
+  }
+  const value_type* At(size_t idx) const {
+    return &Policy::Element(slots_[idx]);
+  }
+  iterator IteratorAt(size_t idx) {
+    return { ctrl_ + idx, slots_ + idx, ctrl_ + capacity_ };
+  }
+  const_iterator IteratorAt(size_t idx) const {
+    return { ctrl_ + idx, slots_ + idx, ctrl_ + capacity_ };
+  }
+
+  template <typename K>
+  size_t Find(const K& key, size_t hash) const {
+    if (capacity_ == 0) return kNpos;
+    for (Probe probe{ hash, capacity_ };; probe.Next()) {
+      Group group{ ctrl_ + probe.Offset() };
+      for (size_t i : group.Match(H2(hash))) {
+        size_t idx = probe.Offset() + i;
+        if (eq_(Policy::Key(*At(idx)), key)) [[likely]] return idx;
+      }
+      if (group.MatchEmpty()) return kNpos;
+    }
+  }
+  /* The first empty or deleted slot on `hash`'s probe sequence. */
+  static size_t FindFirstNonFull(const ctrl_t* ctrl,
+                                 size_t capacity,
+                                 size_t hash) {
+    for (Probe probe{ hash, capacity };; probe.Next()) {
+      auto mask = Group{ ctrl + probe.Offset() }.MatchEmptyOrDeleted();
+      if (mask) return probe.Offset() + mask.Lowest();
+    }
+  }
+  /* Mark the slot at `idx`, just constructed, as full. */
+  void Commit(size_t idx, size_t hash) {
+    growth_left_ -= ctrl_[idx] == kEmpty;
+    ctrl_[idx] = H2(hash);
+    ++size_;
+  }
+  void EraseAt(size_t idx) {
+    traits::destroy(alloc_, At(idx));
+    --size_;
+    /*
+     * A probe only continues past a group without empty slots. If this group
+     * has one, no probe passes through it and the slot can become empty
+     * again; otherwise it must stay a tombstone.
+     */
+    size_t group = idx & ~(kGroupWidth - 1);
+    if (Group{ ctrl_ + group }.MatchEmpty()) {
+      ctrl_[idx] = kEmpty;
+      ++growth_left_;
+    } else {
+      ctrl_[idx] = kDeleted;
+    }
+  }
+
+  ctrl_t* AllocateCtrl(size_t capacity) {
+    ctrl_alloc alloc{ alloc_ };
+    /* Padded by a group so iteration can load a group from any slot. */
+    ctrl_t* ctrl = ctrl_traits::allocate(alloc, capacity + kGroupWidth);
+    std::fill_n(ctrl, capacity + kGroupWidth, kEmpty);
+    return ctrl;
+  }
+  slot_type* AllocateSlots(size_t capacity) {
+    slot_alloc alloc{ alloc_ };
+    return slot_traits::allocate(alloc, capacity);
+  }
+  void Deallocate(ctrl_t* ctrl, slot_type* slots, size_t capacity) {
+    ctrl_alloc alloc{ alloc_ };
+    ctrl_traits::deallocate(alloc, ctrl, capacity + kGroupWidth);
+    slot_alloc slot_allocator{ alloc_ };
+    slot_traits::deallocate(slot_allocator, slots, capacity);
+  }
+  /* Destroy the full slots of the given arrays. */
+  void DestroyFull(const ctrl_t* ctrl, slot_type* slots, size_t capacity) {
+    if constexpr (!std::is_trivially_destructible_v<value_type>) {
+      for (size_t i = 0; i < capacity; ++i) {
+        if (IsFull(ctrl[i])) traits::destroy(alloc_, &Policy::Element(slots[i]));
+      }
+    }
+  }
+
+  /**
+   * Move every element into the given arrays and adopt them.
+   *
+   * Elements that may throw while moving are copied instead, and the old
+   * ones destroyed only once all copies succeeded: on a throw the new arrays
+   * (and anything already in them) are released and the table is unchanged.
+   */
+  void RelocateInto(ctrl_t* ctrl, slot_type* slots, size_t capacity) {
+    if constexpr (Policy::kNothrowRelocate) {
+      for (size_t i = 0; i < capacity_; ++i) {
+        if (!IsFull(ctrl_[i])) continue;
+        size_t hash = Hashed(Policy::Key(*At(i)));
+        size_t idx = FindFirstNonFull(ctrl, capacity, hash);
+        ctrl[idx] = H2(hash);
+        Policy::Relocate(alloc_, slots_ + i, slots + idx);
+      }
+    } else {
+      static_assert(std::is_copy_constructible_v<value_type>,
+                    "Elements must be copyable or nothrow movable.");
+      try {
+        for (size_t i = 0; i < capacity_; ++i) {
+          if (!IsFull(ctrl_[i])) continue;
+          size_t hash = Hashed(Policy::Key(*At(i)));
+          size_t idx = FindFirstNonFull(ctrl, capacity, hash);
+          traits::construct(
+              alloc_, &Policy::Element(slots[idx]), std::as_const(*At(i)));
+          ctrl[idx] = H2(hash);
+        }
+      } catch (...) {
+        DestroyFull(ctrl, slots, capacity);
+        Deallocate(ctrl, slots, capacity);
+        throw;
+      }
+      DestroyFull(ctrl_, slots_, capacity_);
+    }
+    if (capacity_) Deallocate(ctrl_, slots_, capacity_);
+    ctrl_ = ctrl;
+    slots_ = slots;
+    capacity_ = capacity;
+    growth_left_ = MaxLoad(capacity) - size_;
+  }
+  void Resize(size_t capacity) {
+    RelocateInto(AllocateCtrl(capacity), AllocateSlots(capacity), capacity);
+  }
+  /* Construct first, the arguments may alias the current elements. */
+  template <typename... Args>
+  size_t GrowAndEmplace(size_t hash, Args&&... args) {
+    /* Mostly tombstones: rebuilding in place frees enough room. */
+    size_t capacity = size_ < MaxLoad(capacity_) / 2 ? capacity_
+                                                     : CapacityFor(size_ + 1);
+    ctrl_t* ctrl = AllocateCtrl(capacity);
+    slot_type* slots = AllocateSlots(capacity);
+    size_t idx = FindFirstNonFull(ctrl, capacity, hash);
+    try {
+      traits::construct(
+          alloc_, &Policy::Element(slots[idx]), std::forward<Args>(args)...);
+    } catch (...) {
+      Deallocate(ctrl, slots, capacity);
+      throw;
+    }
+    ctrl[idx] = H2(hash);
+    RelocateInto(ctrl, slots, capacity);
+    ++size_;
+    --growth_left_;
+    return idx;
+  }
+
+  void DestroyAll() {
+    DestroyFull(ctrl_, slots_, capacity_);
+  }
+  /* Destroy all elements and release the arrays. */
+  void Reset() {
+    DestroyAll();
+    if (capacity_) Deallocate(ctrl_, slots_, capacity_);
+    ctrl_ = nullptr;
+    slots_ = nullptr;
+    capacity_ = size_ = growth_left_ = 0;
+  }
+  /* Insert copies of `other`'s elements, known to be absent and to fit. */
+  void CopyFrom(const flat_hash_table& other) {
+    for (const value_type& value : other) {
+      size_t hash = Hashed(Policy::Key(value));
+      size_t idx = FindFirstNonFull(ctrl_, capacity_, hash);
+      traits::construct(alloc_, At(idx), value);
+      Commit(idx, hash);
+    }
+  }
+  void Steal(flat_hash_table& other) {
+    ctrl_ = std::exchange(other.ctrl_, nullptr);
+    slots_ = std::exchange(other.slots_, nullptr);
+    capacity_ = std::exchange(other.capacity_, 0);
+    size_ = std::exchange(other.size_, 0);
+    growth_left_ = std::exchange(other.growth_left_, 0);
+  }
+  /* Take `other`'s arrays if possible, else move its elements. */
+  void StealOrMove(flat_hash_table& other) {
+    if (alloc_ == other.alloc_) {
+      Steal(other);
+      return;
+    }
+    reserve(other.size_);
+    for (size_t i = 0; i < other.capacity_; ++i) {
+      if (!IsFull(other.ctrl_[i])) continue;
+      size_t hash = Hashed(Policy::Key(*other.At(i)));
+      size_t idx = FindFirstNonFull(ctrl_, capacity_, hash);
+      Policy::Relocate(alloc_, other.slots_ + i, slots_ + idx);
+      Commit(idx, hash);
+      other.ctrl_[i] = kDeleted;
+    }
+    other.Reset();
+  }
+
+  /* Variables */
+  [[no_unique_address]] Hasher hash_;
+  [[no_unique_address]] KeyEqual eq_;
+  [[no_unique_address]] Alloc alloc_;
+  ctrl_t* ctrl_ = nullptr;
+  slot_type* slots_ = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  size_t growth_left_ = 0;
+};
+
+} // namespace flat_hash_detail
+
+/**
+ * An open addressing hash map storing its elements inline.
+ *
+ * A drop-in for `std::unordered_map` without per-node allocations: a lookup
+ * usually touches one group of control bytes and one slot. Hashes default to
+ * `crystal::Hash`, so string keys can be looked up with a `std::string_view`.
+ *
+ * @note Any insertion may rehash, which moves the elements and invalidates
+ * all iterators and references.
+ *
+ * @tparam K Key type.
+ * @tparam V Mapped type.
+ * @tparam Hasher Hash function. Transparent, together with `KeyEqual`, to
+ * enable heterogeneous lookup.
+ * @tparam KeyEqual Key comparison.
+ * @tparam Alloc Allocator of `std::pair<const K, V>`.
+ */
+template <typename K,
+          typename V,
+          typename Hasher = crystal::Hash<K>,
+          typename KeyEqual = std::equal_to<>,
+          typename Alloc = std::allocator<std::pair<const K, V>>>
+class flat_hash_map :
+    public flat_hash_detail::flat_hash_table<flat_hash_detail::MapPolicy<K, V>,
+                                             Hasher,
+                                             KeyEqual,
+                                             Alloc> {
+  using Base =
+      flat_hash_detail::flat_hash_table<flat_hash_detail::MapPolicy<K, V>,
+                                        Hasher,
+                                        KeyEqual,
+                                        Alloc>;
+  template <typename Key>
+  using key_arg = typename Base::template key_arg<Key>;
+
+ public:
+  using mapped_type = V;
+  using typename Base::const_iterator;
+  using typename Base::iterator;
+  using typename Base::value_type;
+
+  /* Constructors */
+  using Base::Base;
+  flat_hash_map() = default;
+  template <typename Iter>
+  flat_hash_map(Iter begin, Iter end, const Alloc& allocator = {}) :
+      Base(allocator) {
+    insert(begin, end);
+  }
+  flat_hash_map(std::initializer_list<value_type> lst,
+                const Alloc& allocator = {}) :
+      flat_hash_map(lst.begin(), lst.end(), allocator) {
+  }
+
+  /* Element Access */
+  template <typename Key = K>
+  V& at(const key_arg<Key>& key) {
+    auto it = this->find(key);
+    if (it == this->end()) throw std::out_of_range("flat_hash_map::at");
+    return it->second;
+  }
+  template <typename Key = K>
+  const V& at(const key_arg<Key>& key) const {
+    auto it = this->find(key);
+    if (it == this->end()) throw std::out_of_range("flat_hash_map::at");
+    return it->second;
+  }
+  V& operator[](const K& key) {
+    return try_emplace(key).first->second;
+  }
+  V& operator[](K&& key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  /* Modifiers */
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return this->EmplaceKey(value.first, value);
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return this->EmplaceKey(value.first, std::move(value));
+  }
+  template <typename Iter>
+  void insert(Iter begin, Iter end) {
+    while (begin != end) insert(*begin++);
+  }
+  void insert(std::initializer_list<value_type> lst) {
+    insert(lst.begin(), lst.end());
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    value_type value(std::forward<Args>(args)...);
+    return this->EmplaceKey(value.first, std::move(value));
+  }
+  /* Construct the value from `args` only if `key` is absent. */
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+    return this->EmplaceKey(key,
+                            std::piecewise_construct,
+                            std::forward_as_tuple(key),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+    return this->EmplaceKey(key,
+                            std::piecewise_construct,
+                            std::forward_as_tuple(std::move(key)),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const K& key, M&& obj) {
+    auto result = try_emplace(key, std::forward<M>(obj));
+    if (!result.second) result.first->second = std::forward<M>(obj);
+    return result;
+  }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(K&& key, M&& obj) {
+    auto result = try_emplace(std::move(key), std::forward<M>(obj));
+    if (!result.second) result.first->second = std::forward<M>(obj);
+    return result;
+  }
+};
+
+/**
+ * An open addressing hash set storing its elements inline.
+ *
+ * The set counterpart of `flat_hash_map`, with the same layout and rules.
+ *
+ * @tparam K Key type.
+ * @tparam Hasher Hash function.
+ * @tparam KeyEqual Key comparison.
+ * @tparam Alloc Allocator of `K`.
+ */
+template <typename K,
+          typename Hasher = crystal::Hash<K>,
+          typename KeyEqual = std::equal_to<>,
+          typename Alloc = std::allocator<K>>
+class flat_hash_set :
+    public flat_hash_detail::flat_hash_table<flat_hash_detail::SetPolicy<K>,
+                                             Hasher,
+                                             KeyEqual,
+                                             Alloc> {
+  using Base = flat_hash_detail::flat_hash_table<flat_hash_detail::SetPolicy<K>,
+                                                 Hasher,
+                                                 KeyEqual,
+                                                 Alloc>;
+
+ public:
+  using typename Base::const_iterator;
+  using typename Base::iterator;
+
+  /* Constructors */
+  using Base::Base;
+  flat_hash_set() = default;
+  template <typename Iter>
+  flat_hash_set(Iter begin, Iter end, const Alloc& allocator = {}) :
+      Base(allocator) {
+    insert(begin, end);
+  }
+  flat_hash_set(std::initializer_list<K> lst, const Alloc& allocator = {}) :
+      flat_hash_set(lst.begin(), lst.end(), allocator) {
+  }
+
+  /* Modifiers */
+  std::pair<iterator, bool> insert(const K& key) {
+    return this->EmplaceKey(key, key);
+  }
+  std::pair<iterator, bool> insert(K&& key) {
+    return this->EmplaceKey(key, std::move(key));
+  }
+  template <typename Iter>
+  void insert(Iter begin, Iter end) {
+    while (begin != end) insert(*begin++);
+  }
+  void insert(std::initializer_list<K> lst) {
+    insert(lst.begin(), lst.end());
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    K key(std::forward<Args>(args)...);
+    return this->EmplaceKey(key, std::move(key));
+  }
+};
+
+namespace pmr {
+template <typename K,
+          typename V,
+          typename Hasher = crystal::Hash<K>,
+          typename KeyEqual = std::equal_to<>>
+using flat_hash_map =
+    crystal::flat_hash_map<K,
+                           V,
+                           Hasher,
+                           KeyEqual,
+                           std::pmr::polymorphic_allocator<std::pair<const K, V>>>;
+template <typename K,
+          typename Hasher = crystal::Hash<K>,
+          typename KeyEqual = std::equal_to<>>
+using flat_hash_set =
+    crystal::flat_hash_set<K,
+                           Hasher,
+                           KeyEqual,
+                           std::pmr::polymorphic_allocator<K>>;
+} // namespace pmr
+} // namespace crystal
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef CRYSTALBASE_HASH_H_
+#define CRYSTALBASE_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace crystal {
+
+/**
+ * FNV-1a hash of a byte string.
+ *
+ * Usable in constant expressions, so identifiers known at compile time (e.g.
+ * `fixed_string` template arguments) can be turned into integer ids for free.
+ */
+constexpr uint64_t Fnv1a(std::string_view str) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (char c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+namespace hash_detail {
+
+inline constexpr uint64_t kP0 = 0xa0761d6478bd642full;
+inline constexpr uint64_t kP1 = 0xe7037ed1a0b428dbull;
+inline constexpr uint64_t kP2 = 0x8ebc6af09c88c6e3ull;
+
+/* 64x64 -> 128 bit multiply, folded back to 64 bits. */
+constexpr uint64_t Mix(uint64_t a, uint64_t b) {
+  __uint128_t r = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+}
+
+/* Little endian load of `n` (<= 8) bytes. */
+template <size_t kN>
+constexpr uint64_t Load(const char* p) {
+  if (std::is_constant_evaluated()) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < kN; ++i) {
+      v |= uint64_t{ static_cast<unsigned char>(p[i]) } << (8 * i);
+    }
+    return v;
+  } else {
+    std::conditional_t<kN == 8, uint64_t, uint32_t> v;
+    std::memcpy(&v, p, kN);
+    return v;
+  }
+}
+
+} // namespace hash_detail
+
+/**
+ * Fast hash of a byte string.
+ *
+ * Processes 16 bytes per step with a multiply-fold mixer (in the spirit of
+ * wyhash). This is the hash shared by the library's string types, so equal
+ * contents hash equal regardless of the type holding them.
+ */
+constexpr uint64_t HashBytes(std::string_view str, uint64_t seed = 0) {
+  using namespace hash_detail;
+  const char* p = str.data();
+  size_t n = str.size();
+  uint64_t h = seed ^ Mix(seed ^ kP0, kP1);
+  uint64_t a = 0, b = 0;
+  if (n <= 16) {
+    if (n >= 8) {
+      a = Load<8>(p);
+      b = Load<8>(p + n - 8);
+    } else if (n >= 4) {
+      a = Load<4>(p);
+      b = Load<4>(p + n - 4);
+    } else if (n > 0) {
+      a = uint64_t{ static_cast<unsigned char>(p[0]) } << 16
+        | uint64_t{ static_cast<unsigned char>(p[n >> 1]) } << 8
+        | uint64_t{ static_cast<unsigned char>(p[n - 1]) };
+    }
+  } else {
+    for (; n > 16; p += 16, n -= 16) {
+      h = Mix(Load<8>(p) ^ kP1, Load<8>(p + 8) ^ h);
+    }
+    a = Load<8>(p + n - 16);
+    b = Load<8>(p + n - 8);
+  }
+  return Mix(kP1 ^ str.size(), Mix(a ^ kP1, b ^ h) ^ kP2);
+}
+
+/**
+ * Transparent string hasher.
+ *
+ * Hashes anything convertible to `std::string_view` with `HashBytes`, so hash
+ * containers can be looked up with a view without building a key.
+ */
+struct StringHash {
+  using is_transparent = void;
+
+  constexpr size_t operator()(std::string_view str) const {
+    return HashBytes(str);
+  }
+};
+
+/**
+ * The library's default hasher.
+ *
+ * `std::hash` for most types; string-like keys use the transparent
+ * `StringHash` so hash containers accept `std::string_view` lookups.
+ */
+template <typename T>
+struct Hash : std::hash<T> {};
+template <>
+struct Hash<std::string> : StringHash {};
+template <>
+struct Hash<std::string_view> : StringHash {};
+
+} // namespace crystal
+
+#endif
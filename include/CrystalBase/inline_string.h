@@ -0,0 +1,275 @@
+#ifndef CRYSTALBASE_INLINE_STRING_H_
+#define CRYSTALBASE_INLINE_STRING_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <format>
+#include <functional>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+
+#include "fixed_string.h"
+#include "hash.h"
+
+namespace crystal {
+
+/**
+ * A string of runtime length stored inline.
+ *
+ * Holds up to `kCapacity` chars followed by a length byte, never allocates and
+ * is trivially copyable. The interface mirrors `std::string_view` (the type
+ * converts to it implicitly) plus the mutating members of `std::string` that
+ * fit a fixed capacity. Writes past the capacity are truncated; the functions
+ * that may truncate report it.
+ *
+ * Unlike `fixed_string`, the length is not part of the type, so it is the type
+ * to build strings at runtime with.
+ *
+ * @tparam kCapacity The maximum number of chars, at most 255.
+ */
+template <size_t kCapacity>
+class inline_string {
+  static_assert(kCapacity <= UINT8_MAX, "inline_string capacity is at most 255.");
+
+ public:
+  using value_type = char;
+  using size_type = size_t;
+  using iterator = char*;
+  using const_iterator = const char*;
+
+  static constexpr size_t npos = std::string_view::npos;
+
+  /* Constructors */
+  constexpr inline_string() = default;
+  /* From a string literal that is known to fit. */
+  template <size_t kN>
+    requires(kN - 1 <= kCapacity)
+  constexpr inline_string(const char (&str)[kN]) { // NOLINT: implicit
+    (void)append(std::string_view{ str, kN - 1 });
+  }
+  /* From a `fixed_string` that is known to fit. */
+  template <size_t kN>
+    requires(kN <= kCapacity)
+  constexpr inline_string(const fixed_string<kN>& str) { // NOLINT: implicit
+    (void)append(str);
+  }
+  /* From a runtime string, truncated to the capacity. */
+  constexpr explicit inline_string(std::string_view str) {
+    (void)append(str);
+  }
+  constexpr inline_string(size_t count, char c) {
+    (void)append(count, c);
+  }
+
+  /* Conversions */
+  constexpr operator std::string_view() const { // NOLINT: implicit
+    return { data_, size_ };
+  }
+  constexpr std::string_view view() const {
+    return *this;
+  }
+  /**
+   * Convert to a `fixed_string` of the same length.
+   *
+   * @tparam kN The length, which must equal `size()`.
+   */
+  template <size_t kN>
+  constexpr fixed_string<kN> to_fixed_string() const {
+    assert(kN == size_ && "fixed_string length does not match");
+    std::array<char, kN> arr{};
+    std::copy_n(data_, std::min<size_t>(kN, size_), arr.begin());
+    return fixed_string<kN>(arr);
+  }
+
+  /* Element Access */
+  constexpr char& operator[](size_t idx) {
+    return data_[idx];
+  }
+  constexpr char operator[](size_t idx) const {
+    return data_[idx];
+  }
+  constexpr char& front() {
+    return data_[0];
+  }
+  constexpr char front() const {
+    return data_[0];
+  }
+  constexpr char& back() {
+    return data_[size_ - 1];
+  }
+  constexpr char back() const {
+    return data_[size_ - 1];
+  }
+  constexpr char* data() {
+    return data_;
+  }
+  constexpr const char* data() const {
+    return data_;
+  }
+
+  /* Iterators */
+  constexpr char* begin() {
+    return data_;
+  }
+  constexpr const char* begin() const {
+    return data_;
+  }
+  constexpr char* end() {
+    return data_ + size_;
+  }
+  constexpr const char* end() const {
+    return data_ + size_;
+  }
+
+  /* Capacity */
+  constexpr size_t size() const {
+    return size_;
+  }
+  constexpr size_t length() const {
+    return size_;
+  }
+  constexpr bool empty() const {
+    return size_ == 0;
+  }
+  static constexpr size_t capacity() {
+    return kCapacity;
+  }
+  static constexpr size_t max_size() {
+    return kCapacity;
+  }
+
+  /* Modifiers */
+  constexpr void clear() {
+    size_ = 0;
+  }
+  /**
+   * Append chars, truncating at the capacity.
+   *
+   * @return bool Whether all of `str` fit.
+   */
+  constexpr bool append(std::string_view str) {
+    size_t n = std::min(str.size(), kCapacity - size_);
+    std::copy_n(str.data(), n, data_ + size_);
+    size_ += static_cast<uint8_t>(n);
+    return n == str.size();
+  }
+  constexpr bool append(size_t count, char c) {
+    size_t n = std::min(count, kCapacity - size_);
+    std::fill_n(data_ + size_, n, c);
+    size_ += static_cast<uint8_t>(n);
+    return n == count;
+  }
+  constexpr bool push_back(char c) {
+    if (size_ == kCapacity) return false;
+    data_[size_++] = c;
+    return true;
+  }
+  constexpr void pop_back() {
+    --size_;
+  }
+  /* Resize to `min(count, capacity())` chars, filling new ones with `c`. */
+  constexpr void resize(size_t count, char c = '\0') {
+    count = std::min(count, kCapacity);
+    if (count > size_) std::fill_n(data_ + size_, count - size_, c);
+    size_ = static_cast<uint8_t>(count);
+  }
+  constexpr inline_string& operator+=(std::string_view str) {
+    (void)append(str);
+    return *this;
+  }
+  constexpr inline_string& operator+=(char c) {
+    (void)push_back(c);
+    return *this;
+  }
+
+  /* Operations, as on `std::string_view`. */
+  constexpr inline_string substr(size_t pos, size_t count = npos) const {
+    return inline_string{ view().substr(pos, count) };
+  }
+  constexpr size_t find(std::string_view str, size_t pos = 0) const {
+    return view().find(str, pos);
+  }
+  constexpr size_t find(char c, size_t pos = 0) const {
+    return view().find(c, pos);
+  }
+  constexpr size_t rfind(std::string_view str, size_t pos = npos) const {
+    return view().rfind(str, pos);
+  }
+  constexpr size_t rfind(char c, size_t pos = npos) const {
+    return view().rfind(c, pos);
+  }
+  constexpr bool starts_with(std::string_view str) const {
+    return view().starts_with(str);
+  }
+  constexpr bool ends_with(std::string_view str) const {
+    return view().ends_with(str);
+  }
+  constexpr bool contains(std::string_view str) const {
+    return view().find(str) != npos;
+  }
+  constexpr int compare(std::string_view str) const {
+    return view().compare(str);
+  }
+
+  /* Operators */
+  /*
+   * Only the first `size()` chars take part in comparisons. Other inline
+   * strings and literals compare through their `std::string_view`.
+   */
+  constexpr bool operator==(std::string_view other) const {
+    return view() == other;
+  }
+  constexpr std::strong_ordering operator<=>(std::string_view other) const {
+    return view() <=> other;
+  }
+
+ private:
+  char data_[kCapacity]{};
+  uint8_t size_ = 0;
+};
+
+/* Output to stream. */
+template <size_t kCapacity>
+std::ostream& operator<<(std::ostream& os, const inline_string<kCapacity>& str) {
+  return os << static_cast<std::string_view>(str);
+}
+
+/* Concept */
+template <typename T>
+struct is_inline_string : std::false_type {};
+template <size_t kCapacity>
+struct is_inline_string<inline_string<kCapacity>> : std::true_type {};
+template <typename T>
+concept is_inline_string_v = is_inline_string<T>::value;
+
+/* Hashing, transparent to `std::string_view`. */
+template <size_t kCapacity>
+struct Hash<inline_string<kCapacity>> : StringHash {};
+
+} // namespace crystal
+
+namespace std {
+/* Hashing, consistent with `crystal::StringHash` on the same chars. */
+template <size_t kCapacity>
+struct hash<crystal::inline_string<kCapacity>> {
+  size_t operator()(const crystal::inline_string<kCapacity>& str) const noexcept {
+    return crystal::HashBytes(str);
+  }
+};
+/* Formatting */
+template <size_t kCapacity>
+struct formatter<crystal::inline_string<kCapacity>> : formatter<string_view> {
+  auto format(const crystal::inline_string<kCapacity>& str,
+              format_context& ctx) const {
+    return formatter<string_view>::format(str, ctx);
+  }
+};
+} // namespace std
+
+#endif
@@ -0,0 +1,269 @@
+#ifndef CRYSTALBASE_INTERNER_H_
+#define CRYSTALBASE_INTERNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "fixed_string.h"
+#include "hash.h"
+#include "strict_index.h"
+
+namespace crystal {
+
+/* Tag of interned string ids. */
+struct Symbol {};
+using SymbolId = StrictIdx<Symbol, uint32_t>;
+
+/**
+ * A thread safe string interner.
+ *
+ * Maps strings to dense `SymbolId`s (0, 1, 2, ...), so that comparing and
+ * hashing interned strings are integer operations. Characters are copied once
+ * into an arena and never move, so views returned by `str` stay valid for the
+ * lifetime of the interner.
+ *
+ * The table is split into shards selected by hash, each an open addressing
+ * table behind its own reader/writer lock. Resolving an id back to its string
+ * is lock free: each entry is published on its own once written, so shards
+ * never wait for each other.
+ */
+class Interner {
+ public:
+  static constexpr size_t kNShards = 16;
+
+  /* Constructors */
+  Interner() = default;
+  Interner(const Interner&) = delete;
+  Interner& operator=(const Interner&) = delete;
+
+  /* Destructor */
+  ~Interner() {
+    for (auto& segment : segments_) delete[] segment.load(std::memory_order_relaxed);
+  }
+
+  /* The process wide interner. */
+  static Interner& Global() {
+    static Interner interner;
+    return interner;
+  }
+
+  /**
+   * Intern a string.
+   *
+   * @return SymbolId The id of the string, the same for equal strings.
+   */
+  SymbolId intern(std::string_view str) {
+    const uint64_t hash = HashBytes(str);
+    Shard& shard = shards_[ShardIdx(hash)];
+    {
+      std::shared_lock lock{ shard.mutex };
+      if (uint32_t id = Find(shard, str, hash); id != SymbolId::nullvalue) {
+        return id;
+      }
+    }
+    std::unique_lock lock{ shard.mutex };
+    if (uint32_t id = Find(shard, str, hash); id != SymbolId::nullvalue) {
+      return id;
+    }
+    if ((shard.count + 1) * 2 > shard.table.size()) Grow(shard);
+    const char* data = Store(shard, str);
+    const uint32_t id = NextId();
+    Entry& entry = Slot(id);
+    entry.size = static_cast<uint32_t>(str.size());
+    entry.data.store(data, std::memory_order_release);
+    size_.fetch_add(1, std::memory_order_release);
+    size_t mask = shard.table.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+      if (shard.table[i].id == SymbolId::nullvalue) {
+        shard.table[i] = { static_cast<uint32_t>(hash), id };
+        break;
+      }
+    }
+    ++shard.count;
+    return id;
+  }
+  /**
+   * Find an interned string without interning it.
+   *
+   * @return SymbolId The id of the string, or a null id if not interned.
+   */
+  SymbolId find(std::string_view str) const {
+    const uint64_t hash = HashBytes(str);
+    const Shard& shard = shards_[ShardIdx(hash)];
+    std::shared_lock lock{ shard.mutex };
+    return Find(shard, str, hash);
+  }
+  /**
+   * The string of an id returned by this interner.
+   *
+   * @return The string, empty for a null id or one not (yet) interned.
+   */
+  std::string_view str(SymbolId id) const {
+    const Entry* entry = TrySlot(id.get());
+    if (!entry) return {};
+    const char* data = entry->data.load(std::memory_order_acquire);
+    return data ? std::string_view{ data, entry->size } : std::string_view{};
+  }
+  /**
+   * The number of interned strings.
+   *
+   * @note Concurrent `intern`s finish in any order, so an id below it may
+   * still be in flight; `str` returns an empty view for it until then.
+   */
+  size_t size() const {
+    return size_.load(std::memory_order_acquire);
+  }
+
+ private:
+  /* Id -> string, in segments of doubling size so they never move. */
+  static constexpr size_t kSegmentBits = 10;
+  static constexpr size_t kNSegments = 32 - kSegmentBits + 1;
+  static constexpr size_t kBlockSize = 16 * 1024;
+
+  /* Null `data` until the entry is written. */
+  struct Entry {
+    std::atomic<const char*> data = nullptr;
+    uint32_t size = 0;
+  };
+  struct TableSlot {
+    uint32_t hash = 0;
+    uint32_t id = SymbolId::nullvalue;
+  };
+  struct alignas(64) Shard {
+    mutable std::shared_mutex mutex;
+    std::vector<TableSlot> table;
+    size_t count = 0;
+    /* Arena */
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* block_cur = nullptr;
+    size_t block_left = 0;
+  };
+
+  static size_t ShardIdx(uint64_t hash) {
+    return hash >> (64 - std::bit_width(kNShards - 1));
+  }
+  static size_t SegmentIdx(uint32_t id) {
+    return std::bit_width(id >> kSegmentBits);
+  }
+  static size_t SegmentBegin(size_t segment) {
+    return segment ? size_t{ 1 } << (kSegmentBits + segment - 1) : 0;
+  }
+  static size_t SegmentSize(size_t segment) {
+    return size_t{ 1 } << (kSegmentBits + (segment ? segment - 1 : 0));
+  }
+
+  /* The entry of `id`, null if its segment was never allocated. */
+  const Entry* TrySlot(uint32_t id) const {
+    size_t segment = SegmentIdx(id);
+    const Entry* entries = segments_[segment].load(std::memory_order_acquire);
+    return entries ? entries + (id - SegmentBegin(segment)) : nullptr;
+  }
+  Entry& Slot(uint32_t id) {
+    size_t segment = SegmentIdx(id);
+    Entry* entries = segments_[segment].load(std::memory_order_acquire);
+    if (!entries) {
+      auto* fresh = new Entry[SegmentSize(segment)]{};
+      if (segments_[segment].compare_exchange_strong(entries, fresh)) {
+        entries = fresh;
+      } else {
+        delete[] fresh; // another shard won the race, `entries` holds its pointer
+      }
+    }
+    return entries[id - SegmentBegin(segment)];
+  }
+
+  uint32_t Find(const Shard& shard, std::string_view str, uint64_t hash) const {
+    if (shard.table.empty()) return SymbolId::nullvalue;
+    size_t mask = shard.table.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+      const TableSlot& slot = shard.table[i];
+      if (slot.id == SymbolId::nullvalue) return SymbolId::nullvalue;
+      if (slot.hash == static_cast<uint32_t>(hash)) {
+        /* Written under the shard lock we hold. */
+        const Entry& entry = *TrySlot(slot.id);
+        const char* data = entry.data.load(std::memory_order_relaxed);
+        if (std::string_view{ data, entry.size } == str) return slot.id;
+      }
+    }
+  }
+
+  static void Grow(Shard& shard) {
+    std::vector<TableSlot> table(std::max<size_t>(64, shard.table.size() * 2));
+    size_t mask = table.size() - 1;
+    for (const TableSlot& slot : shard.table) {
+      if (slot.id == SymbolId::nullvalue) continue;
+      /* Only the low 32 bits are kept, enough for tables up to 2^32 slots. */
+      for (size_t i = slot.hash & mask;; i = (i + 1) & mask) {
+        if (table[i].id == SymbolId::nullvalue) {
+          table[i] = slot;
+          break;
+        }
+      }
+    }
+    shard.table = std::move(table);
+  }
+
+  /* Take the next id, never the null one. */
+  uint32_t NextId() {
+    uint32_t id = next_id_.load(std::memory_order_relaxed);
+    do {
+      if (id == SymbolId::nullvalue) {
+        throw std::length_error{ "Interner ran out of symbol ids." };
+      }
+    } while (!next_id_.compare_exchange_weak(
+        id, id + 1, std::memory_order_relaxed));
+    return id;
+  }
+
+  /* Copy `str` into the shard's arena. */
+  static const char* Store(Shard& shard, std::string_view str) {
+    if (str.size() > shard.block_left) {
+      size_t size = std::max(kBlockSize, str.size());
+      shard.blocks.push_back(std::make_unique_for_overwrite<char[]>(size));
+      shard.block_cur = shard.blocks.back().get();
+      shard.block_left = size;
+    }
+    char* data = shard.block_cur;
+    if (!str.empty()) std::memcpy(data, str.data(), str.size());
+    shard.block_cur += str.size();
+    shard.block_left -= str.size();
+    return data;
+  }
+
+  /* Variables */
+  std::array<Shard, kNShards> shards_;
+  std::array<std::atomic<Entry*>, kNSegments> segments_{};
+  std::atomic<uint32_t> next_id_{ 0 };
+  std::atomic<uint32_t> size_{ 0 }; // written entries
+};
+
+/* Intern a string in the global interner. */
+inline SymbolId intern(std::string_view str) {
+  return Interner::Global().intern(str);
+}
+/**
+ * Intern a string literal in the global interner.
+ *
+ * The id is resolved on first use and cached, later calls are a load.
+ */
+template <fixed_string kStr>
+SymbolId intern() {
+  static const SymbolId id = Interner::Global().intern(kStr);
+  return id;
+}
+
+} // namespace crystal
+
+#endif
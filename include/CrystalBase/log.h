@@ -0,0 +1,498 @@
+#ifndef CRYSTALBASE_LOG_H_
+#define CRYSTALBASE_LOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "fixed_string.h"
+#include "hash.h"
+#include "static_format.h"
+#include "trace.h"
+
+/**
+ * Deferred binary logging.
+ *
+ * `crystal::Log<"x = {}, y = {}">(x, y)` formats nothing on the calling
+ * thread. The format string is a `fixed_string` template argument, hashed
+ * together with the argument types into a compile time site id; the call
+ * only copies the id, a timestamp and the raw argument bytes into a ring
+ * buffer owned by the thread. A `LogWriter` thread, or an explicit
+ * `FlushLogs`, later turns the records into text, substituting the `{}`
+ * placeholders in order like `static_format` does.
+ *
+ * The number of placeholders must match the number of arguments, which is
+ * checked at compile time. Arguments are arithmetic values, enums, pointers
+ * and strings (anything converting to `std::string_view`, copied in).
+ *
+ * A full buffer drops records rather than blocking the caller; `LogDropped`
+ * counts them.
+ */
+
+#ifndef CRYSTAL_LOG_BUFFER_CAPACITY
+#define CRYSTAL_LOG_BUFFER_CAPACITY (1 << 20)
+#endif
+
+namespace crystal {
+
+/* The fixed part of a log record, followed by the argument bytes. */
+struct LogRecord {
+  uint64_t site; // 0 marks padding up to the end of the ring
+  uint64_t time; // TraceClock ticks
+  uint32_t size; // bytes, this header included, a multiple of 8
+  uint32_t reserved;
+};
+
+namespace log_detail {
+
+/* The type an argument is recorded as. */
+template <typename T>
+struct StoredAs : std::type_identity<std::decay_t<T>> {};
+template <typename T>
+  requires std::is_convertible_v<const T&, std::string_view>
+struct StoredAs<T> : std::type_identity<std::string_view> {};
+template <typename T>
+  requires std::is_enum_v<T>
+struct StoredAs<T> : std::underlying_type<T> {};
+
+template <typename T>
+using Stored = StoredAs<T>::type;
+
+/* `value` as recorded; a null C string is recorded as "(null)". */
+template <typename T>
+Stored<T> ToStored(const T& value) {
+  if constexpr (std::is_pointer_v<T>
+                && std::is_same_v<Stored<T>, std::string_view>) {
+    return value ? std::string_view{ value } : std::string_view{ "(null)" };
+  } else {
+    return static_cast<Stored<T>>(value);
+  }
+}
+
+template <typename T>
+concept Storable = std::is_same_v<T, std::string_view> || std::is_arithmetic_v<T>
+                || std::is_pointer_v<T>;
+
+/* Two characters per argument: its kind and its size. */
+template <Storable... Ts>
+consteval auto Signature() {
+  std::array<char, 2 * sizeof...(Ts)> sig{};
+  size_t i = 0;
+  [[maybe_unused]] auto add = [&]<typename T>(std::type_identity<T>) {
+    if constexpr (std::is_same_v<T, std::string_view>) sig[i] = 's';
+    else if constexpr (std::is_same_v<T, bool>) sig[i] = 'b';
+    else if constexpr (std::is_same_v<T, char>) sig[i] = 'c';
+    else if constexpr (std::is_pointer_v<T>) sig[i] = 'p';
+    else if constexpr (std::is_floating_point_v<T>) sig[i] = 'f';
+    else if constexpr (std::is_signed_v<T>) sig[i] = 'i';
+    else sig[i] = 'u';
+    sig[i + 1] = static_cast<char>('0' + sizeof(T));
+    i += 2;
+  };
+  (add(std::type_identity<Ts>{}), ...);
+  return fixed_string<2 * sizeof...(Ts)>(sig);
+}
+
+/* Bytes an argument takes in a record. */
+template <typename T>
+size_t EncodedSize(const T& value) {
+  if constexpr (std::is_same_v<T, std::string_view>) {
+    return sizeof(uint32_t) + value.size();
+  } else {
+    return sizeof(T);
+  }
+}
+
+template <typename T>
+std::byte* Encode(std::byte* p, const T& value) {
+  if constexpr (std::is_same_v<T, std::string_view>) {
+    const uint32_t size = static_cast<uint32_t>(value.size());
+    std::memcpy(p, &size, sizeof(size));
+    std::memcpy(p + sizeof(size), value.data(), size);
+    return p + sizeof(size) + size;
+  } else {
+    std::memcpy(p, &value, sizeof(T));
+    return p + sizeof(T);
+  }
+}
+
+/* Read an argument back, strings point into the record. */
+template <typename T>
+const std::byte* Decode(const std::byte* p, T& value) {
+  if constexpr (std::is_same_v<T, std::string_view>) {
+    uint32_t size;
+    std::memcpy(&size, p, sizeof(size));
+    value = { reinterpret_cast<const char*>(p + sizeof(size)), size };
+    return p + sizeof(size) + size;
+  } else {
+    std::memcpy(&value, p, sizeof(T));
+    return p + sizeof(T);
+  }
+}
+
+template <typename T>
+void AppendArg(std::string& out, const T& value) {
+  if constexpr (std::is_same_v<T, std::string_view>) {
+    out += value;
+  } else if constexpr (std::is_same_v<T, bool>) {
+    out += value ? "true" : "false";
+  } else if constexpr (std::is_same_v<T, char>) {
+    out += value;
+  } else {
+    char buf[64];
+    std::to_chars_result res;
+    if constexpr (std::is_pointer_v<T>) {
+      out += "0x";
+      const auto address = reinterpret_cast<uintptr_t>(value);
+      res = std::to_chars(buf, buf + sizeof(buf), address, 16);
+    } else {
+      res = std::to_chars(buf, buf + sizeof(buf), value);
+    }
+    out.append(buf, res.ptr);
+  }
+}
+
+/* Format one record of a site logging `Ts...`. */
+template <typename... Ts>
+void Format(std::string_view format, const std::byte* args, std::string& out) {
+  [[maybe_unused]] auto put = [&]<typename T>(std::type_identity<T>) {
+    T value;
+    args = Decode(args, value);
+    const size_t at = format.find("{}");
+    out += format.substr(0, at);
+    AppendArg(out, value);
+    format.remove_prefix(at + 2);
+  };
+  (put(std::type_identity<Ts>{}), ...);
+  out += format;
+}
+
+using Formatter = void (*)(std::string_view, const std::byte*, std::string&);
+
+} // namespace log_detail
+
+/**
+ * Single producer ring buffer of log records owned by one thread.
+ *
+ * Records are contiguous: one that would straddle the end of the ring is
+ * preceded by padding up to the end. Only the owning thread reserves and
+ * commits, the collector drains concurrently.
+ */
+class LogBuffer {
+ public:
+  static constexpr size_t kCapacity = CRYSTAL_LOG_BUFFER_CAPACITY;
+  static_assert((kCapacity & (kCapacity - 1)) == 0 && kCapacity >= 64,
+                "Log buffer capacity must be a power of 2.");
+
+  explicit LogBuffer(uint32_t tid) :
+      tid_{ tid }, data_{ new std::byte[kCapacity] } {
+  }
+
+  uint32_t tid() const {
+    return tid_;
+  }
+  uint64_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+  /* Count a record the owner could not write. */
+  void Drop() {
+    dropped_.store(dropped() + 1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Room for a record of `size` bytes, a multiple of 8.
+   *
+   * @return Where to write the record, null (and the record counted as
+   * dropped) if the buffer is full. Publish it with `Commit`.
+   */
+  std::byte* Reserve(uint32_t size) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    const uint64_t offset = head & (kCapacity - 1);
+    const uint64_t pad = offset + size > kCapacity ? kCapacity - offset : 0;
+    if (head + pad + size - cached_tail_ > kCapacity) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head + pad + size - cached_tail_ > kCapacity) {
+        Drop();
+        return nullptr;
+      }
+    }
+    if (pad != 0) {
+      std::memset(data_.get() + offset, 0, sizeof(uint64_t)); // site 0
+      head += pad;
+    }
+    reserved_ = head;
+    return data_.get() + (head & (kCapacity - 1));
+  }
+  void Commit(uint32_t size) {
+    head_.store(reserved_ + size, std::memory_order_release);
+  }
+
+  /**
+   * Call `visit(record, args)` on every record committed since the last call.
+   *
+   * @note Must not be called concurrently with itself.
+   */
+  template <typename Visit>
+  void Drain(Visit visit) {
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail != head) {
+      const std::byte* p = data_.get() + (tail & (kCapacity - 1));
+      LogRecord record;
+      std::memcpy(&record.site, p, sizeof(record.site));
+      if (record.site == 0) { // padding
+        tail = (tail | (kCapacity - 1)) + 1;
+        continue;
+      }
+      std::memcpy(&record, p, sizeof(record));
+      visit(record, p + sizeof(record));
+      tail += record.size;
+    }
+    tail_.store(tail, std::memory_order_release);
+  }
+
+ private:
+  const uint32_t tid_;
+  std::unique_ptr<std::byte[]> data_;
+  alignas(64) std::atomic<uint64_t> head_{ 0 };
+  uint64_t reserved_ = 0;    // owner side
+  uint64_t cached_tail_ = 0; // owner side
+  std::atomic<uint64_t> dropped_{ 0 };
+  alignas(64) std::atomic<uint64_t> tail_{ 0 }; // collector side
+};
+
+/**
+ * Process wide registry of log sites and per thread buffers.
+ *
+ * Only touched when a site or a thread is seen for the first time and when
+ * flushing, never on the per call path. A buffer whose thread has exited is
+ * released by the first flush that drains it.
+ */
+class LogRegistry {
+ public:
+  static LogRegistry& Instance() {
+    static LogRegistry registry;
+    return registry;
+  }
+
+  bool RegisterSite(uint64_t id,
+                    std::string_view format,
+                    log_detail::Formatter formatter) {
+    std::lock_guard lock{ mutex_ };
+    sites_.emplace(id, Site{ format, formatter });
+    return true;
+  }
+
+  std::shared_ptr<LogBuffer> NewBuffer() {
+    std::lock_guard lock{ mutex_ };
+    auto buffer = std::make_shared<LogBuffer>(next_tid_++);
+    buffers_.push_back(buffer);
+    return buffer;
+  }
+
+  /**
+   * Format the records logged since the last flush into `os`, one line each,
+   * in timestamp order: `[seconds] [thread] message`.
+   *
+   * The lock is only held to copy the records out of the buffers; they are
+   * formatted and written after releasing it, so new threads and sites never
+   * wait for a slow stream.
+   */
+  void Flush(std::ostream& os) {
+    struct Line {
+      uint64_t time;
+      uint32_t tid;
+      const Site* site; // null if unknown
+      size_t args;      // offset in `args`
+    };
+    std::vector<Line> lines;
+    std::vector<std::byte> args;
+    {
+      std::lock_guard lock{ mutex_ };
+      for (auto& buffer : buffers_) {
+        /*
+         * The owner releases its reference after its last commit; once only
+         * ours is left, the acquire fence makes that commit visible to `Drain`.
+         */
+        const bool orphaned = buffer.use_count() == 1;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        buffer->Drain([&](const LogRecord& record, const std::byte* p) {
+          auto site = sites_.find(record.site);
+          lines.push_back({ record.time,
+                            buffer->tid(),
+                            site == sites_.end() ? nullptr : &site->second,
+                            args.size() });
+          args.insert(args.end(), p, p + (record.size - sizeof(LogRecord)));
+        });
+        if (orphaned) {
+          retired_dropped_ += buffer->dropped();
+          buffer = nullptr;
+        }
+      }
+      std::erase(buffers_, nullptr);
+    }
+    if (lines.empty()) return;
+    std::ranges::stable_sort(lines, {}, &Line::time);
+
+    /* Sites are never removed and map nodes never move: `site` stays valid. */
+    const double ns_per_tick = TraceClock::NsPerTick();
+    const uint64_t origin = TraceClock::Origin().ticks;
+    std::string text;
+    for (const Line& line : lines) {
+      text.clear();
+      if (line.site) {
+        line.site->formatter(line.site->format, args.data() + line.args, text);
+      } else {
+        text = "?";
+      }
+      const auto ticks = static_cast<int64_t>(line.time - origin);
+      const double seconds = static_cast<double>(ticks) * ns_per_tick / 1e9;
+      char buf[32];
+      auto res = std::to_chars(
+          buf, buf + sizeof(buf), seconds, std::chars_format::fixed, 6);
+      os << '[' << std::string_view(buf, res.ptr) << "] [" << line.tid << "] "
+         << text << '\n';
+    }
+    os.flush();
+  }
+
+  uint64_t dropped() {
+    std::lock_guard lock{ mutex_ };
+    uint64_t total = retired_dropped_;
+    for (const auto& buffer : buffers_) total += buffer->dropped();
+    return total;
+  }
+  /* The number of buffers not yet released. */
+  size_t buffer_count() {
+    std::lock_guard lock{ mutex_ };
+    return buffers_.size();
+  }
+
+ private:
+  struct Site {
+    std::string_view format;
+    log_detail::Formatter formatter;
+  };
+
+  LogRegistry() {
+    static_cast<void>(TraceClock::Origin()); // timestamps are relative to it
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<uint64_t, Site> sites_;
+  std::vector<std::shared_ptr<LogBuffer>> buffers_;
+  uint32_t next_tid_ = 0;
+  uint64_t retired_dropped_ = 0; // of released buffers
+};
+
+/* The calling thread's log buffer, created on first use. */
+inline LogBuffer& ThreadLogBuffer() {
+  thread_local std::shared_ptr<LogBuffer> buffer =
+      LogRegistry::Instance().NewBuffer();
+  return *buffer;
+}
+
+/* Compile time id of a call site, registered with the collector at startup. */
+template <fixed_string kFormat, typename... Ts>
+struct LogSite {
+  static constexpr auto kStorage = kFormat;
+  static constexpr uint64_t kId =
+      Fnv1a(join<kFormat, fixed_string("\0"), log_detail::Signature<Ts...>()>());
+  static_assert(kId != 0, "Log site id collides with the padding marker.");
+  static inline const bool kRegistered = LogRegistry::Instance().RegisterSite(
+      kId,
+      static_cast<std::string_view>(kStorage),
+      &log_detail::Format<Ts...>);
+};
+
+/**
+ * Log a message, formatted later by `FlushLogs` or a `LogWriter`.
+ *
+ * @tparam kFormat The format string, with one `{}` per argument.
+ */
+template <fixed_string kFormat, typename... Args>
+void Log(const Args&... args) {
+  static_assert(count_placeholders<kFormat>() == sizeof...(Args),
+                "The number of '{}' placeholders and arguments differ.");
+  static_assert((log_detail::Storable<log_detail::Stored<Args>> && ...),
+                "Log arguments must be numbers, enums, pointers or strings.");
+  using Site = LogSite<kFormat, log_detail::Stored<Args>...>;
+  static_cast<void>(&Site::kRegistered);
+
+  /* Converted once: a string's length is only measured here. */
+  auto write = [](const log_detail::Stored<Args>&... values) {
+    const size_t bytes =
+        (sizeof(LogRecord) + ... + log_detail::EncodedSize(values));
+    LogBuffer& buffer = ThreadLogBuffer();
+    if (bytes > LogBuffer::kCapacity) {
+      buffer.Drop();
+      return;
+    }
+    const uint32_t size = static_cast<uint32_t>((bytes + 7) & ~size_t{ 7 });
+    std::byte* p = buffer.Reserve(size);
+    if (!p) return;
+    const LogRecord record{ Site::kId, TraceClock::Now(), size, 0 };
+    std::memcpy(p, &record, sizeof(record));
+    p += sizeof(record);
+    ((p = log_detail::Encode(p, values)), ...);
+    buffer.Commit(size);
+  };
+  write(log_detail::ToStored(args)...);
+}
+
+/* Format every record logged so far into `os`. */
+inline void FlushLogs(std::ostream& os) {
+  LogRegistry::Instance().Flush(os);
+}
+/* Records dropped so far because a buffer was full. */
+inline uint64_t LogDropped() {
+  return LogRegistry::Instance().dropped();
+}
+
+/**
+ * A thread flushing the logs into a stream every `interval`, and once more
+ * when destroyed.
+ */
+class LogWriter {
+ public:
+  explicit LogWriter(
+      std::ostream& os,
+      std::chrono::milliseconds interval = std::chrono::milliseconds{ 10 }) :
+      thread_{ [this, &os, interval](std::stop_token stop) {
+        while (!stop.stop_requested()) {
+          FlushLogs(os);
+          std::unique_lock lock{ mutex_ };
+          wake_.wait_for(lock, stop, interval, [] { return false; });
+        }
+        FlushLogs(os);
+      } } {
+  }
+  LogWriter(const LogWriter&) = delete;
+  LogWriter& operator=(const LogWriter&) = delete;
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable_any wake_;
+  std::jthread thread_; // last: stopped and joined first
+};
+
+} // namespace crystal
+
+#endif
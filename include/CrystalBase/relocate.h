@@ -0,0 +1,39 @@
+#ifndef CRYSTALBASE_RELOCATE_H_
+#define CRYSTALBASE_RELOCATE_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "concepts.h"
+
+namespace crystal {
+
+/**
+ * Move `n` objects from `src` into uninitialized storage at `dst`, ending the
+ * lifetime of the sources.
+ *
+ * Trivially relocatable types are copied with a single `memcpy`.
+ *
+ * @note The ranges must not overlap.
+ */
+template <typename T>
+constexpr void uninitialized_relocate_n(T* src, size_t n, T* dst) {
+  if constexpr (is_trivially_relocatable_v<T>) {
+    if (!std::is_constant_evaluated()) {
+      if (n) std::memcpy(static_cast<void*>(dst), src, n * sizeof(T));
+      return;
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    std::construct_at(dst + i, std::move(src[i]));
+    std::destroy_at(src + i);
+  }
+}
+
+} // namespace crystal
+
+#endif
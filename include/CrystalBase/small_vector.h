@@ -0,0 +1,389 @@
+#ifndef CRYSTALBASE_SMALL_VECTOR_H_
+#define CRYSTALBASE_SMALL_VECTOR_H_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "relocate.h"
+
+namespace crystal {
+
+/**
+ * A vector storing up to `kN` elements inline.
+ *
+ * Behaves like `std::vector` but keeps its first `kN` elements in a buffer
+ * inside the object; only growing past that allocates through `Alloc`.
+ * Trivially relocatable elements (see `is_trivially_relocatable`) are moved
+ * between buffers with `memcpy`.
+ *
+ * @tparam T Element type.
+ * @tparam kN Number of elements stored inline.
+ * @tparam Alloc Allocator used once the inline buffer is exceeded.
+ */
+template <typename T, size_t kN, typename Alloc = std::allocator<T>>
+class small_vector {
+  using traits = std::allocator_traits<Alloc>;
+
+ public:
+  using allocator_type = Alloc; // allocator aware type
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  /* Constructors */
+  small_vector() : small_vector(allocator_type{}) {
+  }
+  explicit small_vector(const allocator_type& allocator) :
+      alloc_{ allocator }, data_{ Inline() } {
+  }
+  explicit small_vector(size_t count, const allocator_type& allocator = {}) :
+      small_vector(allocator) {
+    resize(count);
+  }
+  small_vector(size_t count,
+               const T& value,
+               const allocator_type& allocator = {}) :
+      small_vector(allocator) {
+    resize(count, value);
+  }
+  template <typename Iter>
+  small_vector(Iter begin, Iter end, const allocator_type& allocator = {}) :
+      small_vector(allocator) {
+    while (begin != end) emplace_back(*begin++);
+  }
+  small_vector(std::initializer_list<T> lst,
+               const allocator_type& allocator = {}) :
+      small_vector(lst.begin(), lst.end(), allocator) {
+  }
+  small_vector(const small_vector& other) :
+      small_vector(other,
+                   traits::select_on_container_copy_construction(other.alloc_)) {
+  }
+  small_vector(const small_vector& other, const allocator_type& allocator) :
+      small_vector(allocator) {
+    reserve(other.size_);
+    for (const T& ele : other) {
+      Construct(data_ + size_, ele);
+      ++size_;
+    }
+  }
+  small_vector(small_vector&& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) :
+      small_vector(std::move(other.alloc_)) {
+    StealOrMove(other);
+  }
+  small_vector(small_vector&& other, const allocator_type& allocator) :
+      small_vector(allocator) {
+    StealOrMove(other);
+  }
+
+  /* Assignment Operators */
+  small_vector& operator=(const small_vector& other) {
+    if (this == &other) return *this;
+    if constexpr (traits::propagate_on_container_copy_assignment::value) {
+      if (alloc_ != other.alloc_) {
+        Reset();
+        alloc_ = other.alloc_;
+      }
+    }
+    clear();
+    reserve(other.size_);
+    for (const T& ele : other) {
+      Construct(data_ + size_, ele);
+      ++size_;
+    }
+    return *this;
+  }
+  /* An inline source is moved element by element, which may throw. */
+  small_vector& operator=(small_vector&& other) noexcept(
+      (traits::propagate_on_container_move_assignment::value
+       || traits::is_always_equal::value)
+      && (is_trivially_relocatable_v<T>
+          || std::is_nothrow_move_constructible_v<T>)) {
+    if (this == &other) return *this;
+    Reset();
+    if constexpr (traits::propagate_on_container_move_assignment::value) {
+      alloc_ = std::move(other.alloc_);
+    }
+    StealOrMove(other);
+    return *this;
+  }
+
+  /* Destructor */
+  ~small_vector() {
+    Reset();
+  }
+
+  allocator_type get_allocator() const {
+    return alloc_;
+  }
+
+  /* Element Access */
+  T& at(size_t idx) {
+    if (idx >= size_) throw std::out_of_range("small_vector::at");
+    return data_[idx];
+  }
+  const T& at(size_t idx) const {
+    if (idx >= size_) throw std::out_of_range("small_vector::at");
+    return data_[idx];
+  }
+  T& operator[](size_t idx) {
+    return data_[idx];
+  }
+  const T& operator[](size_t idx) const {
+    return data_[idx];
+  }
+  T& front() {
+    return data_[0];
+  }
+  const T& front() const {
+    return data_[0];
+  }
+  T& back() {
+    return data_[size_ - 1];
+  }
+  const T& back() const {
+    return data_[size_ - 1];
+  }
+  T* data() {
+    return data_;
+  }
+  const T* data() const {
+    return data_;
+  }
+
+  /* Iterators */
+  T* begin() {
+    return data_;
+  }
+  const T* begin() const {
+    return data_;
+  }
+  T* end() {
+    return data_ + size_;
+  }
+  const T* end() const {
+    return data_ + size_;
+  }
+
+  /* Capacity */
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_t capacity() const {
+    return capacity_;
+  }
+  static constexpr size_t inline_capacity() {
+    return kN;
+  }
+  /* Whether the elements are stored in the inline buffer. */
+  bool is_inline() const {
+    return data_ == Inline();
+  }
+  void reserve(size_t n) {
+    if (n > capacity_) Reallocate(n);
+  }
+  /* Move the elements back inline, or into a tighter allocation. */
+  void shrink_to_fit() {
+    if (!is_inline() && size_ < capacity_) Reallocate(size_);
+  }
+
+  /* Modifiers */
+  void clear() {
+    for (T& ele : *this) traits::destroy(alloc_, &ele);
+    size_ = 0;
+  }
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    if (size_ == capacity_) [[unlikely]] {
+      return *GrowAndEmplace(std::forward<Args>(args)...);
+    }
+    T* ele = data_ + size_;
+    Construct(ele, std::forward<Args>(args)...);
+    ++size_;
+    return *ele;
+  }
+  void push_back(const T& ele) {
+    emplace_back(ele);
+  }
+  void push_back(T&& ele) {
+    emplace_back(std::move(ele));
+  }
+  void pop_back() {
+    traits::destroy(alloc_, data_ + --size_);
+  }
+  template <typename... Args>
+  T* emplace(const T* pos, Args&&... args) {
+    size_t idx = pos - data_;
+    emplace_back(std::forward<Args>(args)...);
+    std::rotate(begin() + idx, end() - 1, end());
+    return begin() + idx;
+  }
+  T* insert(const T* pos, const T& ele) {
+    return emplace(pos, ele);
+  }
+  T* insert(const T* pos, T&& ele) {
+    return emplace(pos, std::move(ele));
+  }
+  T* erase(const T* pos) {
+    return erase(pos, pos + 1);
+  }
+  T* erase(const T* first, const T* last) {
+    T* dst = data_ + (first - data_);
+    T* new_end = std::move(data_ + (last - data_), end(), dst);
+    for (T* it = new_end; it != end(); ++it) traits::destroy(alloc_, it);
+    size_ = new_end - data_;
+    return dst;
+  }
+  void resize(size_t count) {
+    reserve(count);
+    while (size_ > count) pop_back();
+    while (size_ < count) {
+      Construct(data_ + size_);
+      ++size_;
+    }
+  }
+  void resize(size_t count, const T& value) {
+    reserve(count);
+    while (size_ > count) pop_back();
+    while (size_ < count) {
+      Construct(data_ + size_, value);
+      ++size_;
+    }
+  }
+
+  /* Operators */
+  bool operator==(const small_vector& other) const {
+    return std::equal(begin(), end(), other.begin(), other.end());
+  }
+
+ private:
+  T* Inline() {
+    return std::launder(reinterpret_cast<T*>(buffer_.data()));
+  }
+  const T* Inline() const {
+    return std::launder(reinterpret_cast<const T*>(buffer_.data()));
+  }
+
+  template <typename... Args>
+  void Construct(T* ptr, Args&&... args) {
+    traits::construct(alloc_, ptr, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Move `n` elements into uninitialized `dst`, then destroy the sources.
+   *
+   * The sources are destroyed only once every element is built: if a copy
+   * throws, the ones built are destroyed and the sources are left intact.
+   */
+  static void Relocate(Alloc& alloc, T* src, size_t n, T* dst) {
+    if constexpr (is_trivially_relocatable_v<T>) {
+      uninitialized_relocate_n(src, n, dst);
+    } else {
+      size_t i = 0;
+      try {
+        for (; i < n; ++i) {
+          traits::construct(alloc, dst + i, std::move_if_noexcept(src[i]));
+        }
+      } catch (...) {
+        for (size_t j = 0; j < i; ++j) traits::destroy(alloc, dst + j);
+        throw;
+      }
+      for (i = 0; i < n; ++i) traits::destroy(alloc, src + i);
+    }
+  }
+
+  void Reallocate(size_t n) {
+    T* fresh = n <= kN ? Inline() : traits::allocate(alloc_, n);
+    if (fresh == data_) return;
+    try {
+      Relocate(alloc_, data_, size_, fresh);
+    } catch (...) {
+      if (fresh != Inline()) traits::deallocate(alloc_, fresh, n);
+      throw;
+    }
+    if (!is_inline()) traits::deallocate(alloc_, data_, capacity_);
+    data_ = fresh;
+    capacity_ = std::max(n, kN);
+  }
+
+  /* Construct first, the arguments may alias the current elements. */
+  template <typename... Args>
+  T* GrowAndEmplace(Args&&... args) {
+    size_t n = std::max<size_t>(capacity_ * 2, 4);
+    T* fresh = traits::allocate(alloc_, n);
+    T* ele = fresh + size_;
+    try {
+      traits::construct(alloc_, ele, std::forward<Args>(args)...);
+    } catch (...) {
+      traits::deallocate(alloc_, fresh, n);
+      throw;
+    }
+    try {
+      Relocate(alloc_, data_, size_, fresh);
+    } catch (...) {
+      traits::destroy(alloc_, ele);
+      traits::deallocate(alloc_, fresh, n);
+      throw;
+    }
+    if (!is_inline()) traits::deallocate(alloc_, data_, capacity_);
+    data_ = fresh;
+    capacity_ = n;
+    ++size_;
+    return ele;
+  }
+
+  /* Destroy all elements and release the heap buffer, if any. */
+  void Reset() {
+    clear();
+    if (!is_inline()) traits::deallocate(alloc_, data_, capacity_);
+    data_ = Inline();
+    capacity_ = kN;
+  }
+
+  /* Take `other`'s heap buffer if possible, else move its elements. */
+  void StealOrMove(small_vector& other) {
+    if (!other.is_inline() && alloc_ == other.alloc_) {
+      data_ = std::exchange(other.data_, other.Inline());
+      size_ = std::exchange(other.size_, 0);
+      capacity_ = std::exchange(other.capacity_, kN);
+      return;
+    }
+    reserve(other.size_);
+    Relocate(alloc_, other.data_, other.size_, data_);
+    size_ = std::exchange(other.size_, 0);
+  }
+
+  /* Variables */
+  [[no_unique_address]] Alloc alloc_;
+  T* data_;
+  size_t size_ = 0;
+  size_t capacity_ = kN;
+  alignas(T) std::array<std::byte, sizeof(T) * kN> buffer_;
+};
+
+namespace pmr {
+template <typename T, size_t kN>
+using small_vector = small_vector<T, kN, std::pmr::polymorphic_allocator<T>>;
+} // namespace pmr
+} // namespace crystal
+
+#endif
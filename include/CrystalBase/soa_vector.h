@@ -0,0 +1,597 @@
+#ifndef CRYSTALBASE_SOA_VECTOR_H_
+#define CRYSTALBASE_SOA_VECTOR_H_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "fixed_string.h"
+#include "relocate.h"
+
+namespace crystal {
+
+/**
+ * A named column of a `soa_vector`.
+ *
+ * @tparam kName The column name, e.g. `field<"pos", Vec3>`.
+ * @tparam T The element type of the column.
+ */
+template <fixed_string kName, typename T>
+struct field {
+  static constexpr auto name = kName;
+  using type = T;
+};
+
+/**
+ * A vector of rows stored column by column (struct of arrays).
+ *
+ * Each field lives in its own contiguous, `kColumnAlignment` aligned array,
+ * so a pass over one field streams only that field through the cache and
+ * vectorizes. `get<"name">()` returns a column as a span; indexing returns a
+ * row proxy. All columns share a single allocation and always have the same
+ * length: every modifier acts on whole rows.
+ *
+ * @tparam Alloc Allocator, rebound to aligned blocks of bytes.
+ * @tparam Fields The columns, as `field<"name", T>`; names must be unique.
+ */
+template <typename Alloc, typename... Fields>
+class basic_soa_vector {
+ public:
+  /* Alignment of each column: a cache line, and the widest SIMD register. */
+  static constexpr size_t kColumnAlignment = 64;
+
+ private:
+  static_assert(sizeof...(Fields) > 0, "soa_vector needs a field.");
+
+  static constexpr size_t kNFields = sizeof...(Fields);
+  using Indices = std::make_index_sequence<kNFields>;
+
+  template <size_t kIdx>
+  using column_t =
+      typename std::tuple_element_t<kIdx, std::tuple<Fields...>>::type;
+
+  struct alignas(kColumnAlignment) Block {
+    std::byte bytes[kColumnAlignment];
+  };
+  using block_alloc =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<Block>;
+  using block_traits = std::allocator_traits<block_alloc>;
+
+  /* The position of the field named `kName`, or `kNFields`. */
+  template <fixed_string kName>
+  static constexpr size_t IndexOf() {
+    std::array<std::string_view, kNFields> names{ Fields::name... };
+    return std::ranges::find(names, std::string_view{ kName }) - names.begin();
+  }
+  static constexpr bool UniqueNames() {
+    std::array<std::string_view, kNFields> names{ Fields::name... };
+    std::ranges::sort(names);
+    return std::ranges::adjacent_find(names) == names.end();
+  }
+  static_assert(UniqueNames(), "soa_vector field names must be unique.");
+
+ public:
+  using allocator_type = Alloc; // allocator aware type
+  using value_type = std::tuple<typename Fields::type...>;
+  using size_type = size_t;
+
+  template <bool kConst>
+  class Iterator;
+
+  /**
+   * A row, referring into the container.
+   *
+   * Invalidated like an iterator: by growth and by erasing before it.
+   */
+  template <bool kConst>
+  class Row {
+    using container =
+        std::conditional_t<kConst, const basic_soa_vector, basic_soa_vector>;
+
+   public:
+    Row(const Row&) = default;
+    operator Row<true>() const // NOLINT: implicit
+      requires(!kConst)
+    {
+      return { vec_, idx_ };
+    }
+
+    template <fixed_string kName>
+    auto& get() const {
+      return vec_->template get<kName>()[idx_];
+    }
+    template <size_t kIdx>
+    auto& get() const {
+      return vec_->template get<kIdx>()[idx_];
+    }
+    size_t index() const {
+      return idx_;
+    }
+
+    /* Copy the row out. */
+    operator value_type() const { // NOLINT: implicit
+      return [this]<size_t... kIs>(std::index_sequence<kIs...>) {
+        return value_type{ get<kIs>()... };
+      }(Indices{});
+    }
+    /* Assign every column of the row. */
+    const Row& operator=(const value_type& value) const
+      requires(!kConst)
+    {
+      [&]<size_t... kIs>(std::index_sequence<kIs...>) {
+        ((get<kIs>() = std::get<kIs>(value)), ...);
+      }(Indices{});
+      return *this;
+    }
+    /* Assigns values, as a reference would. */
+    const Row& operator=(const Row& other) const
+      requires(!kConst)
+    {
+      return *this = static_cast<value_type>(other);
+    }
+
+   private:
+    friend class basic_soa_vector;
+    template <bool>
+    friend class Row;
+    template <bool>
+    friend class Iterator;
+
+    Row(container* vec, size_t idx) : vec_{ vec }, idx_{ idx } {
+    }
+
+    container* vec_;
+    size_t idx_;
+  };
+  using reference = Row<false>;
+  using const_reference = Row<true>;
+
+  /* A random access iterator over row proxies. */
+  template <bool kConst>
+  class Iterator {
+    using container =
+        std::conditional_t<kConst, const basic_soa_vector, basic_soa_vector>;
+
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = basic_soa_vector::value_type;
+    using difference_type = ptrdiff_t;
+    using reference = Row<kConst>;
+
+    Iterator() = default;
+    operator Iterator<true>() const // NOLINT: implicit
+      requires(!kConst)
+    {
+      return { vec_, idx_ };
+    }
+
+    reference operator*() const {
+      return { vec_, idx_ };
+    }
+    reference operator[](difference_type n) const {
+      return { vec_, idx_ + n };
+    }
+    Iterator& operator++() {
+      ++idx_;
+      return *this;
+    }
+    Iterator operator++(int) {
+      return { vec_, idx_++ };
+    }
+    Iterator& operator--() {
+      --idx_;
+      return *this;
+    }
+    Iterator operator--(int) {
+      return { vec_, idx_-- };
+    }
+    Iterator& operator+=(difference_type n) {
+      idx_ += n;
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) {
+      idx_ -= n;
+      return *this;
+    }
+    Iterator operator+(difference_type n) const {
+      return { vec_, idx_ + n };
+    }
+    friend Iterator operator+(difference_type n, const Iterator& it) {
+      return it + n;
+    }
+    Iterator operator-(difference_type n) const {
+      return { vec_, idx_ - n };
+    }
+    difference_type operator-(const Iterator& other) const {
+      return static_cast<difference_type>(idx_)
+           - static_cast<difference_type>(other.idx_);
+    }
+    bool operator==(const Iterator& other) const {
+      return idx_ == other.idx_;
+    }
+    std::strong_ordering operator<=>(const Iterator& other) const {
+      return idx_ <=> other.idx_;
+    }
+
+   private:
+    friend class basic_soa_vector;
+    template <bool>
+    friend class Iterator;
+
+    Iterator(container* vec, size_t idx) : vec_{ vec }, idx_{ idx } {
+    }
+
+    container* vec_ = nullptr;
+    size_t idx_ = 0;
+  };
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  /* Constructors */
+  basic_soa_vector() : basic_soa_vector(allocator_type{}) {
+  }
+  explicit basic_soa_vector(const allocator_type& allocator) :
+      alloc_{ allocator } {
+  }
+  explicit basic_soa_vector(size_t count,
+                            const allocator_type& allocator = {}) :
+      basic_soa_vector(allocator) {
+    resize(count);
+  }
+  basic_soa_vector(std::initializer_list<value_type> lst,
+                   const allocator_type& allocator = {}) :
+      basic_soa_vector(allocator) {
+    reserve(lst.size());
+    for (const value_type& row : lst) push_back(row);
+  }
+  basic_soa_vector(const basic_soa_vector& other) :
+      basic_soa_vector(other,
+                       block_traits::select_on_container_copy_construction(
+                           other.alloc_)) {
+  }
+  basic_soa_vector(const basic_soa_vector& other,
+                   const allocator_type& allocator) :
+      basic_soa_vector(allocator) {
+    CopyFrom(other);
+  }
+  basic_soa_vector(basic_soa_vector&& other) noexcept :
+      alloc_{ std::move(other.alloc_) } {
+    Steal(other);
+  }
+  basic_soa_vector(basic_soa_vector&& other, const allocator_type& allocator) :
+      basic_soa_vector(allocator) {
+    StealOrMove(other);
+  }
+
+  /* Assignment Operators */
+  basic_soa_vector& operator=(const basic_soa_vector& other) {
+    if (this == &other) return *this;
+    if constexpr (block_traits::propagate_on_container_copy_assignment::value) {
+      if (alloc_ != other.alloc_) {
+        Reset();
+        alloc_ = other.alloc_;
+      }
+    }
+    clear();
+    CopyFrom(other);
+    return *this;
+  }
+  basic_soa_vector& operator=(basic_soa_vector&& other) noexcept(
+      block_traits::propagate_on_container_move_assignment::value
+      || block_traits::is_always_equal::value) {
+    if (this == &other) return *this;
+    Reset();
+    if constexpr (block_traits::propagate_on_container_move_assignment::value) {
+      alloc_ = std::move(other.alloc_);
+    }
+    StealOrMove(other);
+    return *this;
+  }
+
+  /* Destructor */
+  ~basic_soa_vector() {
+    Reset();
+  }
+
+  allocator_type get_allocator() const {
+    return allocator_type(alloc_);
+  }
+
+  /* Column Access */
+  template <fixed_string kName>
+  auto get() {
+    constexpr size_t kIdx = IndexOf<kName>();
+    static_assert(kIdx < kNFields, "soa_vector has no field of this name.");
+    return get<kIdx>();
+  }
+  template <fixed_string kName>
+  auto get() const {
+    constexpr size_t kIdx = IndexOf<kName>();
+    static_assert(kIdx < kNFields, "soa_vector has no field of this name.");
+    return get<kIdx>();
+  }
+  template <size_t kIdx>
+  std::span<column_t<kIdx>> get() {
+    return { std::assume_aligned<kColumnAlignment>(Column<kIdx>()), size_ };
+  }
+  template <size_t kIdx>
+  std::span<const column_t<kIdx>> get() const {
+    return { std::assume_aligned<kColumnAlignment>(Column<kIdx>()), size_ };
+  }
+
+  /* Row Access */
+  reference operator[](size_t idx) {
+    return { this, idx };
+  }
+  const_reference operator[](size_t idx) const {
+    return { this, idx };
+  }
+  reference at(size_t idx) {
+    if (idx >= size_) throw std::out_of_range("soa_vector::at");
+    return { this, idx };
+  }
+  const_reference at(size_t idx) const {
+    if (idx >= size_) throw std::out_of_range("soa_vector::at");
+    return { this, idx };
+  }
+  reference front() {
+    return { this, 0 };
+  }
+  const_reference front() const {
+    return { this, 0 };
+  }
+  reference back() {
+    return { this, size_ - 1 };
+  }
+  const_reference back() const {
+    return { this, size_ - 1 };
+  }
+
+  /* Iterators */
+  iterator begin() {
+    return { this, 0 };
+  }
+  const_iterator begin() const {
+    return { this, 0 };
+  }
+  iterator end() {
+    return { this, size_ };
+  }
+  const_iterator end() const {
+    return { this, size_ };
+  }
+
+  /* Capacity */
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_t capacity() const {
+    return capacity_;
+  }
+  void reserve(size_t n) {
+    if (n > capacity_) Reallocate(n);
+  }
+  void shrink_to_fit() {
+    if (size_ < capacity_) Reallocate(size_);
+  }
+
+  /* Modifiers */
+  void clear() {
+    DestroyRows(0, size_);
+    size_ = 0;
+  }
+  /* Append a row, constructing each column from one argument. */
+  template <typename... Args>
+    requires(sizeof...(Args) == kNFields)
+  reference emplace_back(Args&&... args) {
+    if (size_ != capacity_) {
+      ConstructRow(columns_, size_, Indices{}, std::forward<Args>(args)...);
+      return { this, size_++ };
+    }
+    /* The arguments may refer to rows, so build the new row before moving
+     * the old ones out, like `std::vector`. */
+    Storage fresh = Allocate(std::max<size_t>(capacity_ * 2, 8));
+    try {
+      ConstructRow(fresh.columns, size_, Indices{}, std::forward<Args>(args)...);
+    } catch (...) {
+      block_traits::deallocate(alloc_, fresh.blocks, Blocks(fresh.capacity));
+      throw;
+    }
+    Adopt(fresh);
+    return { this, size_++ };
+  }
+  void push_back(const value_type& row) {
+    std::apply([this](const auto&... values) { emplace_back(values...); }, row);
+  }
+  void push_back(value_type&& row) {
+    std::apply([this](auto&&... values) { emplace_back(std::move(values)...); },
+               row);
+  }
+  void pop_back() {
+    --size_;
+    DestroyRows(size_, size_ + 1);
+  }
+  /* Remove a row, shifting the later rows down to keep their order. */
+  void erase(size_t idx) {
+    [&]<size_t... kIs>(std::index_sequence<kIs...>) {
+      ((std::move(Column<kIs>() + idx + 1,
+                  Column<kIs>() + size_,
+                  Column<kIs>() + idx)),
+       ...);
+    }(Indices{});
+    pop_back();
+  }
+  iterator erase(const_iterator pos) {
+    erase(pos.idx_);
+    return { this, pos.idx_ };
+  }
+  /* Remove a row in O(1) by moving the last row into its place. */
+  void swap_erase(size_t idx) {
+    if (idx != size_ - 1) {
+      [&]<size_t... kIs>(std::index_sequence<kIs...>) {
+        ((Column<kIs>()[idx] = std::move(Column<kIs>()[size_ - 1])), ...);
+      }(Indices{});
+    }
+    pop_back();
+  }
+  /* Resize, value initializing new rows. */
+  void resize(size_t count) {
+    reserve(count);
+    if (count < size_) {
+      DestroyRows(count, size_);
+      size_ = count;
+    }
+    while (size_ < count) emplace_back(typename Fields::type{}...);
+  }
+
+ private:
+  using Columns = std::array<void*, kNFields>;
+
+  /* An allocation with room for `capacity` rows. */
+  struct Storage {
+    Block* blocks;
+    Columns columns;
+    size_t capacity;
+  };
+
+  template <size_t kIdx>
+  static column_t<kIdx>* Column(const Columns& columns) {
+    return static_cast<column_t<kIdx>*>(std::get<kIdx>(columns));
+  }
+  template <size_t kIdx>
+  column_t<kIdx>* Column() const {
+    return Column<kIdx>(columns_);
+  }
+
+  template <size_t... kIs, typename... Args>
+  void ConstructRow(const Columns& columns,
+                    size_t idx,
+                    std::index_sequence<kIs...>,
+                    Args&&... args) {
+    size_t built = 0;
+    try {
+      ((std::construct_at(Column<kIs>(columns) + idx, std::forward<Args>(args)),
+        ++built),
+       ...);
+    } catch (...) {
+      ((kIs < built ? std::destroy_at(Column<kIs>(columns) + idx) : void()),
+       ...);
+      throw;
+    }
+  }
+  void DestroyRows(size_t first, size_t last) {
+    [&]<size_t... kIs>(std::index_sequence<kIs...>) {
+      (std::destroy(Column<kIs>() + first, Column<kIs>() + last), ...);
+    }(Indices{});
+  }
+
+  Storage Allocate(size_t n) {
+    Storage fresh{ n ? block_traits::allocate(alloc_, Blocks(n)) : nullptr, {}, n };
+    [&]<size_t... kIs>(std::index_sequence<kIs...>) {
+      std::byte* cursor = reinterpret_cast<std::byte*>(fresh.blocks);
+      ((std::get<kIs>(fresh.columns) = cursor,
+        cursor += Blocks<column_t<kIs>>(n) * sizeof(Block)),
+       ...);
+    }(Indices{});
+    return fresh;
+  }
+  /* Move the rows into `fresh` and release the old allocation. */
+  void Adopt(const Storage& fresh) {
+    [&]<size_t... kIs>(std::index_sequence<kIs...>) {
+      (uninitialized_relocate_n(Column<kIs>(), size_, Column<kIs>(fresh.columns)),
+       ...);
+    }(Indices{});
+    Deallocate();
+    blocks_ = fresh.blocks;
+    columns_ = fresh.columns;
+    capacity_ = fresh.capacity;
+  }
+  void Reallocate(size_t n) {
+    Adopt(Allocate(n));
+  }
+  /* The number of blocks holding `n` elements of a column, or of all. */
+  template <typename T>
+  static constexpr size_t Blocks(size_t n) {
+    return (sizeof(T) * n + sizeof(Block) - 1) / sizeof(Block);
+  }
+  static constexpr size_t Blocks(size_t n) {
+    return (Blocks<typename Fields::type>(n) + ...);
+  }
+  void Deallocate() {
+    if (blocks_) block_traits::deallocate(alloc_, blocks_, Blocks(capacity_));
+  }
+
+  /* Destroy all rows and release the allocation. */
+  void Reset() {
+    clear();
+    Deallocate();
+    blocks_ = nullptr;
+    columns_ = {};
+    capacity_ = 0;
+  }
+  void CopyFrom(const basic_soa_vector& other) {
+    reserve(other.size_);
+    [&]<size_t... kIs>(std::index_sequence<kIs...>) {
+      for (size_t i = 0; i < other.size_; ++i) {
+        ConstructRow(columns_, size_, Indices{}, other.Column<kIs>()[i]...);
+        ++size_;
+      }
+    }(Indices{});
+  }
+  void Steal(basic_soa_vector& other) {
+    blocks_ = std::exchange(other.blocks_, nullptr);
+    columns_ = std::exchange(other.columns_, {});
+    size_ = std::exchange(other.size_, 0);
+    capacity_ = std::exchange(other.capacity_, 0);
+  }
+  /* Take `other`'s allocation if possible, else move its rows. */
+  void StealOrMove(basic_soa_vector& other) {
+    if (alloc_ == other.alloc_) {
+      Steal(other);
+      return;
+    }
+    reserve(other.size_);
+    [&]<size_t... kIs>(std::index_sequence<kIs...>) {
+      (uninitialized_relocate_n(other.Column<kIs>(),
+                                other.size_,
+                                Column<kIs>()),
+       ...);
+    }(Indices{});
+    size_ = std::exchange(other.size_, 0);
+  }
+
+  /* Variables */
+  [[no_unique_address]] block_alloc alloc_;
+  Block* blocks_ = nullptr;
+  Columns columns_{};
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+};
+
+/* A `basic_soa_vector` with the default allocator. */
+template <typename... Fields>
+using soa_vector = basic_soa_vector<std::allocator<std::byte>, Fields...>;
+
+namespace pmr {
+template <typename... Fields>
+using soa_vector =
+    basic_soa_vector<std::pmr::polymorphic_allocator<std::byte>, Fields...>;
+} // namespace pmr
+} // namespace crystal
+
+#endif
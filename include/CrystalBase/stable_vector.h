@@ -70,6 +70,14 @@ class stable_vector {
   size_t capacity() const {
     return arr_.capacity();
   }
+  /* The number of slots, occupied or vacant. Valid indices are below it. */
+  size_t slot_count() const {
+    return arr_.size();
+  }
+  /* Whether the slot at `idx` holds an element. */
+  bool occupied(size_t idx) const {
+    return std::holds_alternative<T>(arr_[idx]);
+  }
 
   /* Modifiers */
   void clear() {
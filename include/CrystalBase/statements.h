@@ -1,6 +1,7 @@
 #ifndef CRYSTALBASE_STATEMENTS_H_
 #define CRYSTALBASE_STATEMENTS_H_
 
+#include "CrystalBase/thread_pool.h"
 #include "CrystalBase/unrolled_for_loop.h"
 
 #endif
@@ -74,6 +74,19 @@ consteval auto static_format_impl() {
   }
 }
 
+/* Number of `{}` placeholders in `format_str`. */
+template <fixed_string format_str>
+consteval size_t count_placeholders() {
+  size_t count = 0;
+  for (size_t i = 0; i + 1 < format_str.size(); ++i) {
+    if (format_str[i] == '{' && format_str[i + 1] == '}') {
+      ++count;
+      ++i;
+    }
+  }
+  return count;
+}
+
 template <fixed_string format_string, auto... args>
 consteval auto static_format() {
   if constexpr (sizeof...(args) == 0) {
@@ -0,0 +1,258 @@
+#ifndef CRYSTALBASE_STATIC_STABLE_VECTOR_H_
+#define CRYSTALBASE_STATIC_STABLE_VECTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <bit>
+#include <expected>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "error.h"
+
+namespace crystal {
+
+/**
+ * A `stable_vector` holding at most `kCapacity` elements inline.
+ *
+ * Same slot semantics as `stable_vector`: indices stay valid until erased,
+ * erased slots go on a free list that `insert`/`emplace` reuse first, while
+ * `push_back`/`emplace_back` always append. Nothing is ever allocated;
+ * occupancy is tracked by a bitset next to the slots. Every member is
+ * `constexpr`, so a pool can be built at compile time.
+ *
+ * Running out of slots is not an exception: the inserting functions return
+ * an `ErrorCategory::kCapacity` error instead of an index.
+ *
+ * @tparam T Element type.
+ * @tparam kCapacity The number of slots.
+ */
+template <typename T, size_t kCapacity>
+class static_stable_vector {
+  static constexpr bool kTrivial = std::is_trivially_destructible_v<T>;
+
+ public:
+  using value_type = T;
+
+  /* Constructors */
+  constexpr static_stable_vector() {
+    /* Constant evaluation forbids slots without an active member. */
+    if (std::is_constant_evaluated()) Vacate();
+  }
+  constexpr static_stable_vector(const static_stable_vector& other) :
+      static_stable_vector() {
+    CopyFrom(other);
+  }
+  constexpr static_stable_vector(static_stable_vector&& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) :
+      static_stable_vector() {
+    CopyFrom(std::move(other));
+  }
+
+  /* Assignment Operators */
+  constexpr static_stable_vector& operator=(const static_stable_vector& other) {
+    if (this != &other) {
+      clear();
+      CopyFrom(other);
+    }
+    return *this;
+  }
+  constexpr static_stable_vector& operator=(static_stable_vector&& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      clear();
+      CopyFrom(std::move(other));
+    }
+    return *this;
+  }
+
+  /* Destructor */
+  constexpr ~static_stable_vector() requires kTrivial = default;
+  constexpr ~static_stable_vector() {
+    clear();
+  }
+
+  /* Element Access */
+  constexpr T& operator[](size_t idx) {
+    return slots_[idx].value;
+  }
+  constexpr const T& operator[](size_t idx) const {
+    return slots_[idx].value;
+  }
+
+  /* Capacity */
+  static constexpr size_t capacity() {
+    return kCapacity;
+  }
+  /* The number of slots, occupied or vacant. Valid indices are below it. */
+  constexpr size_t slot_count() const {
+    return slot_count_;
+  }
+  /* Whether the slot at `idx` holds an element. */
+  constexpr bool occupied(size_t idx) const {
+    return (occupied_[idx / 64] >> (idx % 64)) & 1;
+  }
+  /* Whether `insert` would fail, no slot being vacant. */
+  constexpr bool full() const {
+    return free_head_ == kNullIdx && slot_count_ == kCapacity;
+  }
+
+  /* Modifiers */
+  constexpr void clear() {
+    if constexpr (!kTrivial) {
+      for (size_t word = 0; word < occupied_.size(); ++word) {
+        for (uint64_t bits = occupied_[word]; bits != 0; bits &= bits - 1) {
+          std::destroy_at(&slots_[word * 64 + std::countr_zero(bits)].value);
+        }
+      }
+    }
+    if (std::is_constant_evaluated()) Vacate();
+    occupied_ = {};
+    slot_count_ = 0;
+    free_head_ = kNullIdx;
+  }
+  /**
+   * Push a new element to the back of the container.
+   *
+   * @param ele Element to insert.
+   * @return Index to the inserted element, an error if every slot was used.
+   *
+   * @note Like `stable_vector::push_back`, vacant slots are not reused. For
+   * that, check `insert`.
+   */
+  [[nodiscard]] constexpr std::expected<size_t, Error> push_back(const T& ele) {
+    return emplace_back(ele);
+  }
+  /**
+   * Push a new element to the back of the container.
+   *
+   * @param ele Element to insert.
+   * @return Index to the inserted element, an error if every slot was used.
+   *
+   * @note Like `stable_vector::push_back`, vacant slots are not reused. For
+   * that, check `insert`.
+   */
+  [[nodiscard]] constexpr std::expected<size_t, Error> push_back(T&& ele) {
+    return emplace_back(std::move(ele));
+  }
+  /**
+   * Construct a new element to the back of the container.
+   *
+   * @param args Arguments for constructing the element.
+   * @return Index to the inserted element, an error if every slot was used.
+   */
+  template <typename... Args>
+  [[nodiscard]] constexpr std::expected<size_t, Error> emplace_back(
+      Args&&... args) {
+    if (slot_count_ == kCapacity) return std::unexpected(Full());
+    Construct(slot_count_, std::forward<Args>(args)...);
+    return slot_count_++;
+  }
+  /**
+   * Insert a new element into the container.
+   *
+   * @param ele Element to insert.
+   * @return Index to the inserted element, an error if the container is full.
+   *
+   * @note Vacant slots are reused first, then the element is appended.
+   */
+  [[nodiscard]] constexpr std::expected<size_t, Error> insert(const T& ele) {
+    return emplace(ele);
+  }
+  /**
+   * Insert a new element into the container.
+   *
+   * @param ele Element to insert.
+   * @return Index to the inserted element, an error if the container is full.
+   *
+   * @note Vacant slots are reused first, then the element is appended.
+   */
+  [[nodiscard]] constexpr std::expected<size_t, Error> insert(T&& ele) {
+    return emplace(std::move(ele));
+  }
+  /**
+   * Construct a new element in the container.
+   *
+   * @param args Arguments for constructing the element.
+   * @return Index to the inserted element, an error if the container is full.
+   *
+   * @note Vacant slots are reused first, then the element is appended.
+   */
+  template <typename... Args>
+  [[nodiscard]] constexpr std::expected<size_t, Error> emplace(Args&&... args) {
+    if (free_head_ == kNullIdx) return emplace_back(std::forward<Args>(args)...);
+    const size_t idx = free_head_;
+    free_head_ = slots_[idx].next;
+    Construct(idx, std::forward<Args>(args)...);
+    return idx;
+  }
+  constexpr void erase(size_t idx) {
+    std::destroy_at(&slots_[idx].value);
+    std::construct_at(&slots_[idx].next, free_head_);
+    occupied_[idx / 64] &= ~(uint64_t{ 1 } << (idx % 64));
+    free_head_ = idx;
+  }
+
+ private:
+  static constexpr size_t kNullIdx = static_cast<size_t>(-1);
+
+  /* An element, or the next vacant slot on the free list. */
+  union Slot {
+    constexpr Slot() {
+    }
+    constexpr ~Slot() requires kTrivial = default;
+    constexpr ~Slot() {
+    }
+
+    T value;
+    size_t next;
+  };
+
+  static constexpr Error Full() {
+    return Error{ "static_stable_vector is full.", ErrorCategory::kCapacity };
+  }
+
+  /* Make `next` the active member of every slot. */
+  constexpr void Vacate() {
+    for (Slot& slot : slots_) std::construct_at(&slot.next, kNullIdx);
+  }
+  template <typename... Args>
+  constexpr void Construct(size_t idx, Args&&... args) {
+    std::construct_at(&slots_[idx].value, std::forward<Args>(args)...);
+    occupied_[idx / 64] |= uint64_t{ 1 } << (idx % 64);
+  }
+  /**
+   * Copy (or move) every slot of `other` into this empty container, keeping
+   * its free list.
+   *
+   * @note Slots are counted as they are constructed, so if a copy throws the
+   * container holds (and destroys) exactly the elements copied so far.
+   */
+  template <typename Other>
+  constexpr void CopyFrom(Other&& other) {
+    using Ref =
+        std::conditional_t<std::is_lvalue_reference_v<Other>, const T&, T&&>;
+    for (size_t idx = 0; idx < other.slot_count_; ++idx) {
+      if (other.occupied(idx)) {
+        Construct(idx, static_cast<Ref>(other.slots_[idx].value));
+      } else {
+        std::construct_at(&slots_[idx].next, other.slots_[idx].next);
+      }
+      slot_count_ = idx + 1;
+    }
+    free_head_ = other.free_head_;
+  }
+
+  /* Variables */
+  std::array<Slot, kCapacity> slots_;
+  std::array<uint64_t, (kCapacity + 63) / 64> occupied_{};
+  size_t slot_count_ = 0;
+  size_t free_head_ = kNullIdx;
+};
+
+} // namespace crystal
+
+#endif
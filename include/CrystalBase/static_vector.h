@@ -0,0 +1,302 @@
+#ifndef CRYSTALBASE_STATIC_VECTOR_H_
+#define CRYSTALBASE_STATIC_VECTOR_H_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "relocate.h"
+
+namespace crystal {
+
+/**
+ * A vector with a fixed capacity, stored inline.
+ *
+ * Never allocates. Growing past `kCapacity` throws `std::bad_alloc` from the
+ * throwing members (`push_back`, `emplace_back`, `insert`, `resize`), while
+ * `try_push_back` and `try_emplace_back` return a null pointer instead.
+ *
+ * For trivial `T` the elements live in a plain array, so the container is
+ * trivially copyable and fully usable in constant expressions. Otherwise they
+ * live in raw storage and are constructed on demand.
+ *
+ * @tparam T Element type.
+ * @tparam kCapacity Maximum number of elements.
+ */
+template <typename T, size_t kCapacity>
+class static_vector {
+  static constexpr bool kTrivial = std::is_trivially_default_constructible_v<T>
+                                && std::is_trivially_copyable_v<T>;
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  /* Constructors */
+  constexpr static_vector() {
+    if constexpr (kTrivial) {
+      /* Constant evaluation forbids leaving the unused slots indeterminate. */
+      if (std::is_constant_evaluated()) storage_.elems.fill(T{});
+    }
+  }
+  constexpr explicit static_vector(size_t count) : static_vector() {
+    resize(count);
+  }
+  constexpr static_vector(size_t count, const T& value) : static_vector() {
+    resize(count, value);
+  }
+  template <typename Iter>
+  constexpr static_vector(Iter begin, Iter end) : static_vector() {
+    while (begin != end) push_back(*begin++);
+  }
+  constexpr static_vector(std::initializer_list<T> lst) :
+      static_vector(lst.begin(), lst.end()) {
+  }
+  constexpr static_vector(const static_vector&) requires kTrivial = default;
+  constexpr static_vector(const static_vector& other) : static_vector() {
+    for (const T& ele : other) {
+      std::construct_at(data() + size_, ele);
+      ++size_;
+    }
+  }
+  constexpr static_vector(static_vector&&) requires kTrivial = default;
+  constexpr static_vector(static_vector&& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) :
+      static_vector() {
+    if constexpr (is_trivially_relocatable_v<T>) {
+      uninitialized_relocate_n(other.data(), other.size_, data());
+      size_ = std::exchange(other.size_, 0);
+    } else {
+      for (T& ele : other) {
+        std::construct_at(data() + size_, std::move(ele));
+        ++size_;
+      }
+    }
+  }
+
+  /* Assignment Operators */
+  constexpr static_vector& operator=(const static_vector&) requires kTrivial
+  = default;
+  constexpr static_vector& operator=(const static_vector& other) {
+    if (this != &other) Assign(other.begin(), other.end());
+    return *this;
+  }
+  constexpr static_vector& operator=(static_vector&&) requires kTrivial = default;
+  constexpr static_vector& operator=(static_vector&& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      clear();
+      if constexpr (is_trivially_relocatable_v<T>) {
+        uninitialized_relocate_n(other.data(), other.size_, data());
+        size_ = std::exchange(other.size_, 0);
+      } else {
+        for (T& ele : other) {
+          std::construct_at(data() + size_, std::move(ele));
+          ++size_;
+        }
+      }
+    }
+    return *this;
+  }
+
+  /* Destructor */
+  constexpr ~static_vector() requires kTrivial = default;
+  constexpr ~static_vector() {
+    clear();
+  }
+
+  /* Element Access */
+  constexpr T& at(size_t idx) {
+    if (idx >= size_) throw std::out_of_range("static_vector::at");
+    return data()[idx];
+  }
+  constexpr const T& at(size_t idx) const {
+    if (idx >= size_) throw std::out_of_range("static_vector::at");
+    return data()[idx];
+  }
+  constexpr T& operator[](size_t idx) {
+    return data()[idx];
+  }
+  constexpr const T& operator[](size_t idx) const {
+    return data()[idx];
+  }
+  constexpr T& front() {
+    return data()[0];
+  }
+  constexpr const T& front() const {
+    return data()[0];
+  }
+  constexpr T& back() {
+    return data()[size_ - 1];
+  }
+  constexpr const T& back() const {
+    return data()[size_ - 1];
+  }
+  constexpr T* data() {
+    return storage_.data();
+  }
+  constexpr const T* data() const {
+    return storage_.data();
+  }
+
+  /* Iterators */
+  constexpr T* begin() {
+    return data();
+  }
+  constexpr const T* begin() const {
+    return data();
+  }
+  constexpr T* end() {
+    return data() + size_;
+  }
+  constexpr const T* end() const {
+    return data() + size_;
+  }
+
+  /* Capacity */
+  constexpr size_t size() const {
+    return size_;
+  }
+  constexpr bool empty() const {
+    return size_ == 0;
+  }
+  constexpr bool full() const {
+    return size_ == kCapacity;
+  }
+  static constexpr size_t capacity() {
+    return kCapacity;
+  }
+  static constexpr size_t max_size() {
+    return kCapacity;
+  }
+
+  /* Modifiers */
+  constexpr void clear() {
+    std::destroy(begin(), end());
+    size_ = 0;
+  }
+  /**
+   * Construct a new element at the back of the container.
+   *
+   * @return T* The new element, or `nullptr` if the container is full.
+   */
+  template <typename... Args>
+  constexpr T* try_emplace_back(Args&&... args) {
+    if (size_ == kCapacity) return nullptr;
+    T* ele = std::construct_at(data() + size_, std::forward<Args>(args)...);
+    ++size_;
+    return ele;
+  }
+  constexpr T* try_push_back(const T& ele) {
+    return try_emplace_back(ele);
+  }
+  constexpr T* try_push_back(T&& ele) {
+    return try_emplace_back(std::move(ele));
+  }
+  /**
+   * Construct a new element at the back of the container.
+   *
+   * @throw std::bad_alloc If the container is full.
+   */
+  template <typename... Args>
+  constexpr T& emplace_back(Args&&... args) {
+    if (size_ == kCapacity) throw std::bad_alloc();
+    return *try_emplace_back(std::forward<Args>(args)...);
+  }
+  constexpr void push_back(const T& ele) {
+    emplace_back(ele);
+  }
+  constexpr void push_back(T&& ele) {
+    emplace_back(std::move(ele));
+  }
+  constexpr void pop_back() {
+    std::destroy_at(data() + --size_);
+  }
+  template <typename... Args>
+  constexpr T* emplace(const T* pos, Args&&... args) {
+    size_t idx = pos - begin();
+    emplace_back(std::forward<Args>(args)...);
+    std::rotate(begin() + idx, end() - 1, end());
+    return begin() + idx;
+  }
+  constexpr T* insert(const T* pos, const T& ele) {
+    return emplace(pos, ele);
+  }
+  constexpr T* insert(const T* pos, T&& ele) {
+    return emplace(pos, std::move(ele));
+  }
+  constexpr T* erase(const T* pos) {
+    return erase(pos, pos + 1);
+  }
+  constexpr T* erase(const T* first, const T* last) {
+    T* dst = begin() + (first - begin());
+    T* src = begin() + (last - begin());
+    T* new_end = std::move(src, end(), dst);
+    std::destroy(new_end, end());
+    size_ = new_end - begin();
+    return dst;
+  }
+  constexpr void resize(size_t count) {
+    if (count > kCapacity) throw std::bad_alloc();
+    while (size_ > count) pop_back();
+    while (size_ < count) emplace_back();
+  }
+  constexpr void resize(size_t count, const T& value) {
+    if (count > kCapacity) throw std::bad_alloc();
+    while (size_ > count) pop_back();
+    while (size_ < count) emplace_back(value);
+  }
+
+  /* Operators */
+  constexpr bool operator==(const static_vector& other) const {
+    return std::equal(begin(), end(), other.begin(), other.end());
+  }
+
+ private:
+  template <typename Iter>
+  constexpr void Assign(Iter first, Iter last) {
+    clear();
+    while (first != last) push_back(*first++);
+  }
+
+  struct TrivialStorage {
+    std::array<T, kCapacity> elems;
+    constexpr T* data() {
+      return elems.data();
+    }
+    constexpr const T* data() const {
+      return elems.data();
+    }
+  };
+  struct RawStorage {
+    alignas(T) std::array<std::byte, sizeof(T) * kCapacity> bytes;
+    T* data() {
+      return std::launder(reinterpret_cast<T*>(bytes.data()));
+    }
+    const T* data() const {
+      return std::launder(reinterpret_cast<const T*>(bytes.data()));
+    }
+  };
+
+  /* Variables */
+  std::conditional_t<kTrivial, TrivialStorage, RawStorage> storage_;
+  size_t size_ = 0;
+};
+
+} // namespace crystal
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef CRYSTALBASE_STRING_SEARCH_H_
+#define CRYSTALBASE_STRING_SEARCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <string_view>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fixed_string.h"
+
+namespace crystal {
+
+/* A match of `find_any`. */
+struct search_match {
+  size_t pos = std::string_view::npos; // npos when nothing matched
+  size_t pattern = 0;                  // index of the matching pattern
+
+  constexpr explicit operator bool() const {
+    return pos != std::string_view::npos;
+  }
+  constexpr bool operator==(const search_match&) const = default;
+};
+
+namespace search_detail {
+
+#if defined(__AVX2__)
+inline constexpr size_t kBlock = 32;
+
+/* Bit i set when `p[i] == first` and `p[i + gap] == last`. */
+inline uint32_t Candidates(const char* p, char first, char last, size_t gap) {
+  const __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  const __m256i tail =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + gap));
+  const __m256i eq =
+      _mm256_and_si256(_mm256_cmpeq_epi8(head, _mm256_set1_epi8(first)),
+                       _mm256_cmpeq_epi8(tail, _mm256_set1_epi8(last)));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+}
+#elif defined(__SSE2__)
+inline constexpr size_t kBlock = 16;
+
+/* Bit i set when `p[i] == first` and `p[i + gap] == last`. */
+inline uint32_t Candidates(const char* p, char first, char last, size_t gap) {
+  const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + gap));
+  const __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(head, _mm_set1_epi8(first)),
+                                   _mm_cmpeq_epi8(tail, _mm_set1_epi8(last)));
+  return static_cast<uint32_t>(_mm_movemask_epi8(eq));
+}
+#else
+inline constexpr size_t kBlock = 0; // scalar only
+#endif
+
+/**
+ * Search for any of `kPatterns`, specialized on them at compile time.
+ *
+ * Long haystacks are scanned a SIMD block at a time: a window is a candidate
+ * only when both its first and its last byte match a pattern, and only
+ * candidates are compared in full. The remainder, and the whole haystack on
+ * targets without SIMD, goes through Horspool (set Horspool for several
+ * patterns) with a shift table built at compile time.
+ */
+template <fixed_string... kPatterns>
+struct Searcher {
+  static_assert(sizeof...(kPatterns) > 0, "No pattern to search for.");
+  static_assert(((kPatterns.size() > 0) && ...), "Empty search pattern.");
+
+  static constexpr size_t kMinSize = std::min({ kPatterns.size()... });
+  static constexpr size_t kMaxSize = std::max({ kPatterns.size()... });
+
+  /**
+   * Horspool shifts over the first `kMinSize` bytes of every pattern: how far
+   * a window may move when its last byte is `c`.
+   */
+  static constexpr std::array<uint32_t, 256> kShift = [] {
+    std::array<uint32_t, 256> shift;
+    shift.fill(kMinSize);
+    auto add = [&](std::string_view pattern) {
+      for (size_t j = 0; j + 1 < kMinSize; ++j) {
+        uint32_t& s = shift[static_cast<uint8_t>(pattern[j])];
+        s = std::min<uint32_t>(s, kMinSize - 1 - j);
+      }
+    };
+    (add(kPatterns), ...);
+    return shift;
+  }();
+
+  /* Index of the first pattern occurring at `p`, -1 if none. */
+  static int MatchAt(const char* p, size_t avail) {
+    int idx = 0;
+    int found = -1;
+    auto test = [&](std::string_view pattern) {
+      if (pattern.size() <= avail
+          && std::memcmp(p, pattern.data(), pattern.size()) == 0) {
+        found = idx;
+        return true;
+      }
+      ++idx;
+      return false;
+    };
+    (test(kPatterns) || ...);
+    return found;
+  }
+
+  static search_match Find(std::string_view haystack, size_t pos) {
+    const char* data = haystack.data();
+    const size_t size = haystack.size();
+    if (pos > size || size - pos < kMinSize) return {};
+
+    if constexpr (sizeof...(kPatterns) == 1 && kMinSize == 1) {
+      const void* hit = std::memchr(data + pos, (kPatterns[0], ...), size - pos);
+      if (!hit) return {};
+      return { static_cast<size_t>(static_cast<const char*>(hit) - data), 0 };
+    }
+
+    size_t i = pos;
+    if constexpr (kBlock != 0) {
+      /* A block covers the windows at [i, i + kBlock); every load stays in. */
+      for (; i + kBlock + kMaxSize - 1 <= size; i += kBlock) {
+        uint32_t mask = (Candidates(data + i,
+                                    kPatterns[0],
+                                    kPatterns[kPatterns.size() - 1],
+                                    kPatterns.size() - 1)
+                         | ...);
+        while (mask != 0) {
+          const size_t at = i + std::countr_zero(mask);
+          if (int idx = MatchAt(data + at, size - at); idx >= 0) {
+            return { at, static_cast<size_t>(idx) };
+          }
+          mask &= mask - 1;
+        }
+      }
+    }
+    while (i + kMinSize <= size) {
+      if (int idx = MatchAt(data + i, size - i); idx >= 0) {
+        return { i, static_cast<size_t>(idx) };
+      }
+      i += kShift[static_cast<uint8_t>(data[i + kMinSize - 1])];
+    }
+    return {};
+  }
+};
+
+} // namespace search_detail
+
+/**
+ * Find the first occurrence of `kPattern` in `haystack` at or after `pos`.
+ *
+ * Like `std::string_view::find`, but the pattern is known at compile time:
+ * its skip table is precomputed and long haystacks are filtered with SIMD
+ * (AVX2 or SSE2, whichever the target is compiled for).
+ *
+ * @return The position of the match, `std::string_view::npos` if none.
+ */
+template <fixed_string kPattern>
+size_t find(std::string_view haystack, size_t pos = 0) {
+  if constexpr (kPattern.size() == 0) {
+    return pos <= haystack.size() ? pos : std::string_view::npos;
+  } else {
+    return search_detail::Searcher<kPattern>::Find(haystack, pos).pos;
+  }
+}
+
+/**
+ * Find the first occurrence of any of `kPatterns` in `haystack`, at or after
+ * `pos`, in a single pass.
+ *
+ * @return The earliest match; among patterns matching at the same position,
+ * the one listed first. Converts to false if nothing matched.
+ */
+template <fixed_string... kPatterns>
+search_match find_any(std::string_view haystack, size_t pos = 0) {
+  return search_detail::Searcher<kPatterns...>::Find(haystack, pos);
+}
+
+} // namespace crystal
+
+#endif
@@ -0,0 +1,634 @@
+#ifndef CRYSTALBASE_THREAD_POOL_H_
+#define CRYSTALBASE_THREAD_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "small_vector.h"
+#include "stable_vector.h"
+
+namespace crystal {
+
+/**
+ * A Chase-Lev work stealing deque.
+ *
+ * The owning thread pushes and pops at the bottom (LIFO), any other thread
+ * steals from the top (FIFO). No operation takes a lock; an owner pop only
+ * races with thieves, through a CAS, for the very last item.
+ *
+ * The ring buffer grows on the owner's side. Thieves may still read a
+ * replaced buffer, so old buffers are kept until the deque is destroyed.
+ *
+ * @tparam T A trivially copyable item, typically a task pointer.
+ */
+template <typename T>
+class work_stealing_deque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "work_stealing_deque items are copied racily.");
+
+  struct Buffer {
+    explicit Buffer(size_t capacity) :
+        mask{ capacity - 1 }, items{ new std::atomic<T>[capacity] } {
+    }
+    size_t capacity() const {
+      return mask + 1;
+    }
+    T Get(int64_t idx) const {
+      return items[idx & mask].load(std::memory_order_relaxed);
+    }
+    void Put(int64_t idx, T item) {
+      items[idx & mask].store(item, std::memory_order_relaxed);
+    }
+
+    size_t mask;
+    std::unique_ptr<std::atomic<T>[]> items;
+  };
+
+ public:
+  /* Constructors */
+  explicit work_stealing_deque(size_t capacity = 256) {
+    buffers_.push_back(std::make_unique<Buffer>(std::bit_ceil(capacity)));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+  }
+  work_stealing_deque(const work_stealing_deque&) = delete;
+  work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+  /* Capacity, a snapshot under concurrency. */
+  size_t size() const {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? b - t : 0;
+  }
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /* Owner only: add an item at the bottom. */
+  void push(T item) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    if (b - t >= static_cast<int64_t>(buffer->capacity())) {
+      buffer = Grow(buffer, t, b);
+    }
+    buffer->Put(b, item);
+    bottom_.store(b + 1, std::memory_order_release);
+  }
+  /* Owner only: take the most recently pushed item. */
+  std::optional<T> pop() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) { // empty
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    T item = buffer->Get(b);
+    if (t == b) { // last item, race the thieves for it
+      bool won = top_.compare_exchange_strong(t,
+                                              t + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      if (!won) return std::nullopt;
+    }
+    return item;
+  }
+  /* Any thread: take the oldest item. May fail spuriously under contention. */
+  std::optional<T> steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) return std::nullopt;
+    T item = buffer_.load(std::memory_order_acquire)->Get(t);
+    if (!top_.compare_exchange_strong(t,
+                                      t + 1,
+                                      std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return std::nullopt;
+    }
+    return item;
+  }
+
+ private:
+  Buffer* Grow(Buffer* buffer, int64_t top, int64_t bottom) {
+    auto fresh = std::make_unique<Buffer>(buffer->capacity() * 2);
+    for (int64_t i = top; i < bottom; ++i) fresh->Put(i, buffer->Get(i));
+    buffers_.push_back(std::move(fresh));
+    buffer_.store(buffers_.back().get(), std::memory_order_release);
+    return buffers_.back().get();
+  }
+
+  /* Variables */
+  alignas(64) std::atomic<int64_t> top_ = 0;
+  alignas(64) std::atomic<int64_t> bottom_ = 0;
+  std::atomic<Buffer*> buffer_;
+  std::vector<std::unique_ptr<Buffer>> buffers_; // owner only
+};
+
+namespace thread_pool_detail {
+
+/* A CPU the process may run on. */
+struct Cpu {
+  int id;
+  int node;
+};
+
+/* The NUMA node of a CPU, from sysfs. 0 when unknown. */
+inline int NumaNode([[maybe_unused]] int cpu) {
+#if defined(__linux__)
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  fs::directory_iterator it{ "/sys/devices/system/cpu/cpu" + std::to_string(cpu),
+                             ec };
+  for (; !ec && it != fs::directory_iterator{}; it.increment(ec)) {
+    std::string name = it->path().filename().string();
+    if (name.size() > 4 && name.starts_with("node")) {
+      return std::atoi(name.c_str() + 4);
+    }
+  }
+#endif
+  return 0;
+}
+
+/* The CPUs in the process affinity mask, grouped by NUMA node. */
+inline std::vector<Cpu> AvailableCpus() {
+  std::vector<Cpu> cpus;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int i = 0; i < CPU_SETSIZE; ++i) {
+      if (CPU_ISSET(i, &set)) cpus.push_back({ i, NumaNode(i) });
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    unsigned n = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned i = 0; i < n; ++i) cpus.push_back({ -1, 0 });
+  }
+  std::ranges::stable_sort(cpus, {}, &Cpu::node);
+  return cpus;
+}
+
+inline void PinCurrentThread([[maybe_unused]] int cpu) {
+#if defined(__linux__)
+  if (cpu < 0) return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+/* Spin loop hint. */
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#else
+  std::this_thread::yield();
+#endif
+}
+
+} // namespace thread_pool_detail
+
+/**
+ * A work stealing thread pool for fork-join loops.
+ *
+ * Every worker owns a `work_stealing_deque`. A loop is split in halves
+ * recursively down to the grain; the halves not run right away are pushed on
+ * the running thread's deque, where idle workers steal them. Spawning and
+ * stealing never take a lock. Idle workers spin briefly, then sleep on an
+ * atomic epoch that spawns only touch while someone sleeps.
+ *
+ * On Linux the workers are pinned to the CPUs of the process affinity mask,
+ * filled NUMA node by node. Each worker allocates its own deque (first touch
+ * keeps it node local) and steals from its own node before crossing nodes.
+ *
+ * A thread calling into the pool runs its loop alongside the workers, so a
+ * pool of `n` threads runs loops `n + 1` wide. Up to `kCallerSlots` outside
+ * threads may do so concurrently; further ones run their loops serially.
+ */
+class ThreadPool {
+ public:
+  static constexpr size_t kAutoThreads = static_cast<size_t>(-1);
+  static constexpr size_t kCallerSlots = 8;
+
+  struct Options {
+    /* Worker threads, by default one per available CPU but the caller's. */
+    size_t num_threads = kAutoThreads;
+    /* Pin each worker to one CPU (Linux only). */
+    bool pin_threads = true;
+  };
+
+  /* Constructors */
+  ThreadPool() : ThreadPool(Options{}) {
+  }
+  explicit ThreadPool(Options options) :
+      num_threads_{ ResolveThreads(options) },
+      slots_(num_threads_ + kCallerSlots),
+      created_{ static_cast<ptrdiff_t>(num_threads_ + 1) } {
+    auto cpus = thread_pool_detail::AvailableCpus();
+    std::vector<int> nodes(num_threads_);
+    threads_.reserve(num_threads_);
+    for (size_t i = 0; i < num_threads_; ++i) {
+      const auto& cpu = cpus[i % cpus.size()];
+      nodes[i] = cpu.node;
+      int pin = options.pin_threads ? cpu.id : -1;
+      threads_.emplace_back([this, i, pin] {
+        thread_pool_detail::PinCurrentThread(pin);
+        slots_[i] = std::make_unique<Slot>();
+        created_.count_down();
+        ready_.wait();
+        WorkerLoop(*slots_[i]);
+      });
+    }
+    for (size_t i = num_threads_; i < slots_.size(); ++i) {
+      slots_[i] = std::make_unique<Slot>();
+    }
+    created_.arrive_and_wait();
+    AssignVictims(nodes);
+    ready_.count_down();
+  }
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /* Destructor */
+  ~ThreadPool() {
+    stop_.store(true, std::memory_order_relaxed);
+    epoch_.fetch_add(1, std::memory_order_release);
+    epoch_.notify_all();
+    for (std::thread& thread : threads_) thread.join();
+  }
+
+  /* The process wide pool. */
+  static ThreadPool& Global() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  /* The number of worker threads. */
+  size_t size() const {
+    return num_threads_;
+  }
+  /* The number of threads running a loop, the caller included. */
+  size_t concurrency() const {
+    return num_threads_ + 1;
+  }
+
+  /**
+   * Call `op` on every element of `range` in parallel.
+   *
+   * The range is split into chunks of `grain` elements; each chunk runs
+   * sequentially on one thread. The first exception thrown by `op` is
+   * rethrown once the loop finished; chunks not started by then are skipped.
+   *
+   * @param range Random access range, e.g. `std::views::iota(0uz, n)`.
+   * @param grain Elements per chunk, large enough to amortize a steal.
+   * @param op Called concurrently as `op(element)`.
+   */
+  template <std::ranges::random_access_range R, typename Op>
+    requires std::ranges::sized_range<R>
+  void parallel_for(R&& range, size_t grain, Op op) {
+    auto first = std::ranges::begin(range);
+    auto body = [&](size_t lo, size_t hi) {
+      for (size_t i = lo; i < hi; ++i) {
+        std::invoke(op, first[static_cast<std::ranges::range_difference_t<R>>(i)]);
+      }
+    };
+    Execute(std::ranges::size(range), grain, body);
+  }
+  /* Call `op(idx, element)` on every occupied slot of a `stable_vector`. */
+  template <typename T, typename Alloc, typename Op>
+  void parallel_for(stable_vector<T, Alloc>& vec, size_t grain, Op op) {
+    parallel_for(std::views::iota(size_t{ 0 }, vec.slot_count()),
+                 grain,
+                 [&](size_t idx) {
+                   if (vec.occupied(idx)) std::invoke(op, idx, vec[idx]);
+                 });
+  }
+  template <typename T, typename Alloc, typename Op>
+  void parallel_for(const stable_vector<T, Alloc>& vec, size_t grain, Op op) {
+    parallel_for(std::views::iota(size_t{ 0 }, vec.slot_count()),
+                 grain,
+                 [&](size_t idx) {
+                   if (vec.occupied(idx)) std::invoke(op, idx, vec[idx]);
+                 });
+  }
+
+  /**
+   * Reduce `transform(element)` over `range` in parallel.
+   *
+   * Each chunk is reduced on its own, then the partial results are folded
+   * into `init` in range order, so `reduce` needs to be associative but not
+   * commutative, and the result does not depend on scheduling.
+   */
+  template <std::ranges::random_access_range R,
+            typename T,
+            typename Reduce,
+            typename Transform = std::identity>
+    requires std::ranges::sized_range<R>
+  T parallel_reduce(R&& range,
+                    size_t grain,
+                    T init,
+                    Reduce reduce,
+                    Transform transform = {}) {
+    using diff_t = std::ranges::range_difference_t<R>;
+    const size_t n = std::ranges::size(range);
+    grain = std::max<size_t>(grain, 1);
+    small_vector<std::optional<T>, 16> partials((n + grain - 1) / grain);
+    auto first = std::ranges::begin(range);
+    auto body = [&](size_t lo, size_t hi) {
+      T acc = std::invoke(transform, first[static_cast<diff_t>(lo)]);
+      for (size_t i = lo + 1; i < hi; ++i) {
+        acc = std::invoke(reduce,
+                          std::move(acc),
+                          std::invoke(transform, first[static_cast<diff_t>(i)]));
+      }
+      partials[lo / grain].emplace(std::move(acc));
+    };
+    Execute(n, grain, body);
+    for (std::optional<T>& partial : partials) {
+      init = std::invoke(reduce, std::move(init), std::move(*partial));
+    }
+    return init;
+  }
+
+ private:
+  struct Loop;
+  /* Chunks [lo, hi) of a loop. */
+  struct Task {
+    Loop* loop = nullptr;
+    size_t lo = 0;
+    size_t hi = 0;
+  };
+  /* A `parallel_for` in flight, living on the caller's stack. */
+  struct Loop {
+    size_t n = 0;
+    size_t grain = 0;
+    void (*body)(void*, size_t, size_t) = nullptr;
+    void* op = nullptr;
+    Task* tasks = nullptr; // one per chunk, indexed by the task's first chunk
+    std::atomic<size_t> pending = 0; // chunks not yet finished
+    std::atomic<bool> failed = false;
+    std::exception_ptr error = nullptr;
+  };
+  struct alignas(64) Slot {
+    work_stealing_deque<Task*> deque;
+    std::vector<Slot*> victims; // steal order
+    std::atomic<bool> claimed = false; // caller slots only
+  };
+  /* Where the current thread runs its loops. */
+  struct Context {
+    ThreadPool* pool = nullptr;
+    Slot* slot = nullptr;
+  };
+
+  static constexpr int kSpins = 64;
+
+  static Context& CurrentContext() {
+    thread_local Context context;
+    return context;
+  }
+
+  static size_t ResolveThreads(const Options& options) {
+    if (options.num_threads != kAutoThreads) return options.num_threads;
+    return thread_pool_detail::AvailableCpus().size() - 1;
+  }
+
+  /*
+   * Workers try their own node first, then the callers' slots (where loops
+   * start), then the other nodes. Each list starts at the next index, so
+   * thieves spread over the victims.
+   */
+  void AssignVictims(const std::vector<int>& nodes) {
+    const size_t n = num_threads_;
+    for (size_t i = 0; i < n; ++i) {
+      auto& victims = slots_[i]->victims;
+      for (size_t k = 1; k < n; ++k) {
+        size_t j = (i + k) % n;
+        if (nodes[j] == nodes[i]) victims.push_back(slots_[j].get());
+      }
+      for (size_t j = n; j < slots_.size(); ++j) {
+        victims.push_back(slots_[j].get());
+      }
+      for (size_t k = 1; k < n; ++k) {
+        size_t j = (i + k) % n;
+        if (nodes[j] != nodes[i]) victims.push_back(slots_[j].get());
+      }
+    }
+    for (size_t i = n; i < slots_.size(); ++i) {
+      auto& victims = slots_[i]->victims;
+      for (size_t k = 0; k < n; ++k) {
+        victims.push_back(slots_[(i + k) % n].get());
+      }
+      for (size_t j = n; j < slots_.size(); ++j) {
+        if (j != i) victims.push_back(slots_[j].get());
+      }
+    }
+  }
+
+  Slot* ClaimCallerSlot() {
+    for (size_t i = num_threads_; i < slots_.size(); ++i) {
+      std::atomic<bool>& claimed = slots_[i]->claimed;
+      if (!claimed.load(std::memory_order_relaxed)
+          && !claimed.exchange(true, std::memory_order_acquire)) {
+        return slots_[i].get();
+      }
+    }
+    return nullptr;
+  }
+
+  Task* FindTask(Slot& slot) {
+    if (auto task = slot.deque.pop()) return *task;
+    for (Slot* victim : slot.victims) {
+      if (auto task = victim->deque.steal()) return *task;
+    }
+    return nullptr;
+  }
+  bool HasWork(const Slot& slot) const {
+    if (!slot.deque.empty()) return true;
+    return std::ranges::any_of(slot.victims,
+                               [](const Slot* v) { return !v->deque.empty(); });
+  }
+
+  void Spawn(Slot& slot, Task* task) {
+    slot.deque.push(task);
+    /* Pairs with the fence in `WorkerLoop`: a sleeper sees the task or us it. */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) != 0) {
+      epoch_.fetch_add(1, std::memory_order_release);
+      epoch_.notify_one();
+    }
+  }
+
+  /* Split off the upper halves until one chunk is left, then run it. */
+  void Run(Task& task, Slot& slot) {
+    Loop& loop = *task.loop;
+    size_t lo = task.lo;
+    size_t hi = task.hi;
+    while (hi - lo > 1) {
+      size_t mid = lo + (hi - lo) / 2;
+      loop.tasks[mid] = { &loop, mid, hi };
+      Spawn(slot, &loop.tasks[mid]);
+      hi = mid;
+    }
+    if (!loop.failed.load(std::memory_order_relaxed)) {
+      try {
+        loop.body(loop.op, lo * loop.grain, std::min(hi * loop.grain, loop.n));
+      } catch (...) {
+        if (!loop.failed.exchange(true)) loop.error = std::current_exception();
+      }
+    }
+    /* The caller may return as soon as this hits zero. */
+    loop.pending.fetch_sub(1, std::memory_order_release);
+  }
+
+  /* Help out until every chunk of `loop` has run. */
+  void Join(Loop& loop, Slot& slot) {
+    int spins = 0;
+    while (loop.pending.load(std::memory_order_acquire) != 0) {
+      if (Task* task = FindTask(slot)) {
+        Run(*task, slot);
+        spins = 0;
+      } else if (++spins < kSpins) {
+        thread_pool_detail::CpuRelax();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /* Run `body(lo, hi)` on every chunk of [0, n). */
+  template <typename Body>
+  void Execute(size_t n, size_t grain, Body& body) {
+    if (n == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    const size_t chunks = (n + grain - 1) / grain;
+    Context& context = CurrentContext();
+    Slot* slot = context.pool == this ? context.slot : nullptr;
+    Slot* claimed = nullptr;
+    if (chunks > 1 && !slot) slot = claimed = ClaimCallerSlot();
+    if (chunks == 1 || !slot) {
+      for (size_t lo = 0; lo < n; lo += grain) body(lo, std::min(lo + grain, n));
+      return;
+    }
+    const Context saved = context;
+    if (claimed) context = { this, claimed };
+
+    small_vector<Task, 64> tasks(chunks);
+    Loop loop{ .n = n,
+               .grain = grain,
+               .body = [](void* op, size_t lo, size_t hi) {
+                 (*static_cast<Body*>(op))(lo, hi);
+               },
+               .op = &body,
+               .tasks = tasks.data(),
+               .pending = chunks };
+    tasks[0] = { &loop, 0, chunks };
+    Run(tasks[0], *slot);
+    Join(loop, *slot);
+
+    if (claimed) {
+      context = saved;
+      claimed->claimed.store(false, std::memory_order_release);
+    }
+    if (loop.error) std::rethrow_exception(loop.error);
+  }
+
+  void WorkerLoop(Slot& slot) {
+    CurrentContext() = { this, &slot };
+    int spins = 0;
+    while (true) {
+      if (Task* task = FindTask(slot)) {
+        Run(*task, slot);
+        spins = 0;
+        continue;
+      }
+      if (++spins < kSpins) {
+        thread_pool_detail::CpuRelax();
+        continue;
+      }
+      spins = 0;
+      uint32_t epoch = epoch_.load(std::memory_order_acquire);
+      sleepers_.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (stop_.load(std::memory_order_relaxed)) break;
+      if (!HasWork(slot)) epoch_.wait(epoch, std::memory_order_acquire);
+      sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  /* Variables */
+  size_t num_threads_;
+  std::vector<std::unique_ptr<Slot>> slots_; // workers, then callers
+  std::vector<std::thread> threads_;
+  std::latch created_;
+  std::latch ready_{ 1 };
+  alignas(64) std::atomic<uint32_t> epoch_ = 0;
+  alignas(64) std::atomic<uint32_t> sleepers_ = 0;
+  std::atomic<bool> stop_ = false;
+};
+
+/* `ThreadPool::parallel_for` on the global pool. */
+template <std::ranges::random_access_range R, typename Op>
+  requires std::ranges::sized_range<R>
+void parallel_for(R&& range, size_t grain, Op op) {
+  ThreadPool::Global().parallel_for(std::forward<R>(range), grain, std::move(op));
+}
+template <typename T, typename Alloc, typename Op>
+void parallel_for(stable_vector<T, Alloc>& vec, size_t grain, Op op) {
+  ThreadPool::Global().parallel_for(vec, grain, std::move(op));
+}
+template <typename T, typename Alloc, typename Op>
+void parallel_for(const stable_vector<T, Alloc>& vec, size_t grain, Op op) {
+  ThreadPool::Global().parallel_for(vec, grain, std::move(op));
+}
+
+/* `ThreadPool::parallel_reduce` on the global pool. */
+template <std::ranges::random_access_range R,
+          typename T,
+          typename Reduce,
+          typename Transform = std::identity>
+  requires std::ranges::sized_range<R>
+T parallel_reduce(R&& range,
+                  size_t grain,
+                  T init,
+                  Reduce reduce,
+                  Transform transform = {}) {
+  return ThreadPool::Global().parallel_reduce(std::forward<R>(range),
+                                              grain,
+                                              std::move(init),
+                                              std::move(reduce),
+                                              std::move(transform));
+}
+
+} // namespace crystal
+
+#endif
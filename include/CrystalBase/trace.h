@@ -0,0 +1,333 @@
+#ifndef CRYSTALBASE_TRACE_H_
+#define CRYSTALBASE_TRACE_H_
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "error.h"
+#include "fixed_string.h"
+#include "hash.h"
+
+/**
+ * Scoped tracing.
+ *
+ * `CRYSTAL_TRACE_SCOPE("name")` records a span from the statement to the end
+ * of the enclosing scope. Span names are `fixed_string` template arguments
+ * hashed into integer ids at compile time; each thread appends begin/end
+ * timestamps to a ring buffer it owns, and `WriteChromeTrace` exports all
+ * buffers in the Chrome trace event format (chrome://tracing, Perfetto).
+ *
+ * Tracing is compiled in only when `CRYSTAL_ENABLE_TRACING` is defined to a
+ * non zero value; otherwise the macro expands to nothing.
+ */
+
+#ifndef CRYSTAL_TRACE_BUFFER_CAPACITY
+#define CRYSTAL_TRACE_BUFFER_CAPACITY (1 << 16)
+#endif
+
+namespace crystal {
+
+/* Timestamps: the time stamp counter where available, else steady_clock. */
+struct TraceClock {
+  static uint64_t Now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+  }
+  static uint64_t SteadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+  /* The tick and steady_clock readings all trace timestamps are relative to. */
+  struct Anchor {
+    uint64_t ticks;
+    uint64_t ns;
+  };
+  static const Anchor& Origin() {
+    static const Anchor origin{ Now(), SteadyNs() };
+    return origin;
+  }
+  /* Calibrate ticks against steady_clock, spinning for at least 10ms. */
+  static double NsPerTick() {
+    const Anchor& origin = Origin();
+    uint64_t ticks, ns;
+    do {
+      ticks = Now();
+      ns = SteadyNs();
+    } while (ns - origin.ns < 10'000'000);
+    return static_cast<double>(ns - origin.ns)
+         / static_cast<double>(ticks - origin.ticks);
+  }
+};
+
+/* A completed span. */
+struct TraceRecord {
+  uint64_t id;
+  uint64_t begin;
+  uint64_t end;
+};
+
+/**
+ * Single producer ring buffer of trace records owned by one thread.
+ *
+ * Only the owning thread pushes; the collector reads concurrently. When full
+ * the oldest records are overwritten, the collector drops records it may have
+ * observed half written.
+ */
+class TraceBuffer {
+ public:
+  static constexpr size_t kCapacity = CRYSTAL_TRACE_BUFFER_CAPACITY;
+  static_assert((kCapacity & (kCapacity - 1)) == 0,
+                "Trace buffer capacity must be a power of 2.");
+
+  explicit TraceBuffer(uint32_t tid) : tid_{ tid }, slots_{ new Slot[kCapacity] } {
+  }
+
+  uint32_t tid() const {
+    return tid_;
+  }
+
+  void Push(uint64_t id, uint64_t begin, uint64_t end) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    /*
+     * Orders the previous head store before the slot writes: a collector that
+     * reads any of them then sees `head_` at least at this slot, and drops it.
+     */
+    std::atomic_thread_fence(std::memory_order_release);
+    Slot& slot = slots_[head & (kCapacity - 1)];
+    slot.id.store(id, std::memory_order_relaxed);
+    slot.begin.store(begin, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * Append the records pushed since the last call to `out`.
+   *
+   * @note Must not be called concurrently with itself.
+   */
+  void Drain(std::vector<TraceRecord>& out) {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t first = head > kCapacity ? std::max(tail_, head - kCapacity) : tail_;
+    size_t old_size = out.size();
+    for (uint64_t i = first; i < head; ++i) {
+      const Slot& slot = slots_[i & (kCapacity - 1)];
+      out.push_back({ slot.id.load(std::memory_order_relaxed),
+                      slot.begin.load(std::memory_order_relaxed),
+                      slot.end.load(std::memory_order_relaxed) });
+    }
+    /*
+     * Drop what the producer may have overwritten while we were reading,
+     * including the slot it may be writing right now (index `new_head`).
+     */
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t new_head = head_.load(std::memory_order_relaxed);
+    if (new_head + 1 > kCapacity + first) {
+      size_t overwritten =
+          std::min<uint64_t>(new_head + 1 - kCapacity - first, head - first);
+      out.erase(out.begin() + old_size, out.begin() + old_size + overwritten);
+    }
+    tail_ = head;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> id{ 0 };
+    std::atomic<uint64_t> begin{ 0 };
+    std::atomic<uint64_t> end{ 0 };
+  };
+
+  const uint32_t tid_;
+  std::unique_ptr<Slot[]> slots_;
+  alignas(64) std::atomic<uint64_t> head_{ 0 };
+  alignas(64) uint64_t tail_ = 0; // collector side
+};
+
+/**
+ * Process wide registry of span names and per thread buffers.
+ *
+ * Only touched when a span name or a thread is seen for the first time and
+ * when collecting, never on the per span path. A buffer whose thread has
+ * exited is released by the first export that drains it.
+ */
+class TraceRegistry {
+ public:
+  static TraceRegistry& Instance() {
+    static TraceRegistry registry;
+    return registry;
+  }
+
+  bool RegisterName(uint64_t id, std::string_view name) {
+    std::lock_guard lock{ mutex_ };
+    names_.emplace(id, name);
+    return true;
+  }
+
+  std::shared_ptr<TraceBuffer> NewBuffer() {
+    std::lock_guard lock{ mutex_ };
+    auto buffer = std::make_shared<TraceBuffer>(next_tid_++);
+    buffers_.push_back(buffer);
+    return buffer;
+  }
+
+  /**
+   * Export the spans recorded since the last export as Chrome trace JSON.
+   */
+  void WriteChromeTrace(std::ostream& os) {
+    std::lock_guard lock{ mutex_ };
+    const double ns_per_tick = TraceClock::NsPerTick();
+    const uint64_t origin = TraceClock::Origin().ticks;
+    auto to_us = [&](uint64_t ticks) {
+      return static_cast<double>(static_cast<int64_t>(ticks - origin))
+           * ns_per_tick / 1e3;
+    };
+
+    os << "{\"traceEvents\":[";
+    bool first = true;
+    std::vector<TraceRecord> records;
+    for (auto& buffer : buffers_) {
+      /*
+       * The owner releases its reference after its last push; once only ours
+       * is left, the acquire fence makes that push visible to `Drain`.
+       */
+      const bool orphaned = buffer.use_count() == 1;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      records.clear();
+      buffer->Drain(records);
+      for (const TraceRecord& r : records) {
+        auto name = names_.find(r.id);
+        os << (first ? "\n" : ",\n") << "{\"name\":";
+        WriteJsonString(
+            os, name != names_.end() ? name->second : std::string_view{ "?" });
+        os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid()
+           << ",\"ts\":" << to_us(r.begin)
+           << ",\"dur\":" << to_us(r.end) - to_us(r.begin) << '}';
+        first = false;
+      }
+      if (orphaned) buffer = nullptr;
+    }
+    std::erase(buffers_, nullptr);
+    os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+  }
+
+  /* The number of buffers not yet released. */
+  size_t buffer_count() {
+    std::lock_guard lock{ mutex_ };
+    return buffers_.size();
+  }
+
+ private:
+  TraceRegistry() {
+    static_cast<void>(TraceClock::Origin()); // before any span is recorded
+  }
+
+  /* `str` as a quoted JSON string. */
+  static void WriteJsonString(std::ostream& os, std::string_view str) {
+    os << '"';
+    for (char c : str) {
+      if (c == '"' || c == '\\') {
+        os << '\\' << c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        static constexpr char kHex[] = "0123456789abcdef";
+        os << "\\u00" << kHex[c >> 4] << kHex[c & 0xf];
+      } else {
+        os << c;
+      }
+    }
+    os << '"';
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<uint64_t, std::string_view> names_;
+  std::vector<std::shared_ptr<TraceBuffer>> buffers_;
+  uint32_t next_tid_ = 0;
+};
+
+/* The calling thread's trace buffer, created on first use. */
+inline TraceBuffer& ThreadTraceBuffer() {
+  thread_local std::shared_ptr<TraceBuffer> buffer =
+      TraceRegistry::Instance().NewBuffer();
+  return *buffer;
+}
+
+/* Compile time id of a span name, registered with the collector at startup. */
+template <fixed_string kName>
+struct TraceName {
+  static constexpr uint64_t kId = Fnv1a(kName);
+  static constexpr auto kStorage = kName;
+  static inline const bool kRegistered = TraceRegistry::Instance().RegisterName(
+      kId, static_cast<std::string_view>(kStorage));
+};
+
+/**
+ * RAII span: timestamps on construction, records on destruction.
+ *
+ * @tparam kName The span name, a string literal.
+ */
+template <fixed_string kName>
+class TraceScope {
+ public:
+  TraceScope() : begin_{ TraceClock::Now() } {
+    static_cast<void>(&TraceName<kName>::kRegistered);
+  }
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+  ~TraceScope() {
+    ThreadTraceBuffer().Push(TraceName<kName>::kId, begin_, TraceClock::Now());
+  }
+
+ private:
+  uint64_t begin_;
+};
+
+/* Export all recorded spans as Chrome trace JSON. */
+inline void WriteChromeTrace(std::ostream& os) {
+  TraceRegistry::Instance().WriteChromeTrace(os);
+}
+inline std::expected<void, Error> WriteChromeTrace(
+    const std::filesystem::path& file_path) {
+  std::ofstream os{ file_path };
+  if (!os.good()) {
+    return std::unexpected(
+        Error{ "Cannot open trace file.", ErrorCategory::kSystem, errno });
+  }
+  WriteChromeTrace(os);
+  return {};
+}
+
+} // namespace crystal
+
+#define CRYSTAL_TRACE_CONCAT_IMPL(a, b) a##b
+#define CRYSTAL_TRACE_CONCAT(a, b) CRYSTAL_TRACE_CONCAT_IMPL(a, b)
+
+#if defined(CRYSTAL_ENABLE_TRACING) && CRYSTAL_ENABLE_TRACING
+#define CRYSTAL_TRACE_SCOPE(name)                   \
+  ::crystal::TraceScope<name> CRYSTAL_TRACE_CONCAT( \
+      crystal_trace_scope_, __LINE__) {}
+#else
+#define CRYSTAL_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
+
+#endif
@@ -4,6 +4,6 @@
 
 int main() {
   crystal::Error e{"123"};
-  std::cout << e.msg << std::endl;
+  std::cout << e.msg() << std::endl;
   return 0;
 }
\ No newline at end of file
@@ -1,11 +1,27 @@
 #include "CrystalBase/base.h"
 #include "CrystalBase/bitwise.h"
 #include "CrystalBase/concepts.h"
+#include "CrystalBase/concurrent_queue.h"
 #include "CrystalBase/containers.h"
+#include "CrystalBase/error.h"
+#include "CrystalBase/file_io.h"
 #include "CrystalBase/fixed_string.h"
+#include "CrystalBase/flat_hash_map.h"
+#include "CrystalBase/hash.h"
+#include "CrystalBase/inline_string.h"
 #include "CrystalBase/integer_sequence.h"
+#include "CrystalBase/interner.h"
+#include "CrystalBase/log.h"
+#include "CrystalBase/relocate.h"
+#include "CrystalBase/small_vector.h"
+#include "CrystalBase/soa_vector.h"
 #include "CrystalBase/stable_vector.h"
 #include "CrystalBase/statements.h"
 #include "CrystalBase/static_format.h"
+#include "CrystalBase/static_stable_vector.h"
+#include "CrystalBase/static_vector.h"
 #include "CrystalBase/strict_index.h"
+#include "CrystalBase/string_search.h"
+#include "CrystalBase/thread_pool.h"
+#include "CrystalBase/trace.h"
 #include "CrystalBase/unrolled_for_loop.h"
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CrystalBase/concurrent_queue.h"
+
+TEST(SpscQueue, FifoUpToCapacity) {
+  crystal::spsc_queue<std::string, 4> queue;
+  EXPECT_TRUE(queue.empty());
+  for (int i = 0; i < 4; ++i) EXPECT_TRUE(queue.try_push(std::to_string(i)));
+  EXPECT_FALSE(queue.try_emplace("full"));
+  EXPECT_EQ(queue.size(), 4);
+  EXPECT_EQ(queue.try_pop(), "0");
+  EXPECT_TRUE(queue.try_emplace(3, 'x'));
+  EXPECT_EQ(queue.pop(), "1");
+  EXPECT_EQ(queue.size(), 3);
+  /* The remaining items are destroyed with the queue. */
+}
+
+TEST(SpscQueue, Batches) {
+  crystal::spsc_queue<int, 8> queue;
+  std::vector<int> in = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  EXPECT_EQ(queue.try_push_n(in.begin(), 5), 5);
+  EXPECT_EQ(queue.try_push_n(in.begin() + 5, 5), 3); // as many as fit
+
+  std::vector<int> out;
+  EXPECT_EQ(queue.try_pop_n(std::back_inserter(out), 6), 6);
+  EXPECT_EQ(queue.try_pop_n(std::back_inserter(out), 6), 2);
+  EXPECT_EQ(queue.try_pop_n(std::back_inserter(out), 6), 0);
+  EXPECT_EQ(out, std::vector<int>(in.begin(), in.begin() + 8));
+}
+
+TEST(SpscQueue, BlockingHandOff) {
+  constexpr int kItems = 200000;
+  auto queue = std::make_unique<crystal::spsc_queue<int, 16>>();
+  std::thread producer{ [&] {
+    for (int i = 0; i < kItems; i += 4) {
+      if (i % 8 == 0) {
+        for (int j = i; j < i + 4; ++j) queue->push(j);
+      } else {
+        int batch[] = { i, i + 1, i + 2, i + 3 };
+        for (size_t pushed = 0; pushed < 4;) {
+          size_t n = queue->try_push_n(batch + pushed, 4 - pushed);
+          if (n == 0) std::this_thread::yield();
+          pushed += n;
+        }
+      }
+    }
+  } };
+  bool ordered = true;
+  for (int i = 0; i < kItems; ++i) ordered &= queue->pop() == i;
+  producer.join();
+  EXPECT_TRUE(ordered);
+  EXPECT_TRUE(queue->empty());
+}
+
+TEST(MpmcQueue, FifoAndBatches) {
+  crystal::mpmc_queue<std::string, 8> queue;
+  EXPECT_TRUE(queue.try_push("a"));
+  EXPECT_TRUE(queue.try_emplace(2, 'b'));
+  EXPECT_EQ(queue.try_pop(), "a");
+
+  std::vector<std::string> in = { "c", "d", "e", "f", "g", "h", "i", "j" };
+  EXPECT_EQ(queue.try_push_n(std::make_move_iterator(in.begin()), in.size()), 7);
+  EXPECT_FALSE(queue.try_push("full"));
+  EXPECT_EQ(queue.size(), 8);
+
+  std::vector<std::string> out;
+  EXPECT_EQ(queue.try_pop_n(std::back_inserter(out), 3), 3);
+  EXPECT_EQ(out, (std::vector<std::string>{ "bb", "c", "d" }));
+  EXPECT_EQ(queue.pop(), "e");
+  EXPECT_EQ(queue.size(), 4);
+}
+
+TEST(MpmcQueue, ConcurrentProducersAndConsumers) {
+  constexpr int kThreads = 4;
+  constexpr int kPerProducer = 50000;
+  auto queue = std::make_unique<crystal::mpmc_queue<int, 64>>();
+  std::vector<std::atomic<int>> seen(kThreads * kPerProducer);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      const int base = t * kPerProducer;
+      for (int i = 0; i < kPerProducer; i += 2) {
+        if (t % 2 == 0) {
+          queue->push(base + i);
+          queue->push(base + i + 1);
+        } else {
+          int batch[] = { base + i, base + i + 1 };
+          for (size_t pushed = 0; pushed < 2;) {
+            size_t n = queue->try_push_n(batch + pushed, 2 - pushed);
+            if (n == 0) std::this_thread::yield();
+            pushed += n;
+          }
+        }
+      }
+    });
+    threads.emplace_back([&, t] {
+      int item[2];
+      for (int i = 0; i < kPerProducer;) {
+        if (t % 2 == 0) {
+          seen[queue->pop()].fetch_add(1, std::memory_order_relaxed);
+          ++i;
+        } else {
+          size_t popped = queue->try_pop_n(item, std::min(2, kPerProducer - i));
+          if (popped == 0) std::this_thread::yield();
+          for (size_t j = 0; j < popped; ++j) seen[item[j]].fetch_add(1);
+          i += popped;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  /* Every item is popped exactly once. */
+  int once = 0;
+  for (auto& count : seen) once += count.load() == 1;
+  EXPECT_EQ(once, kThreads * kPerProducer);
+  EXPECT_TRUE(queue->empty());
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include <cerrno>
+
+#include <string>
+#include <type_traits>
+
+#include "CrystalBase/error.h"
+#include "CrystalBase/file_io.h"
+
+TEST(ErrorTest, StaticMessage) {
+  crystal::Error err{ "Cannot open file.", crystal::ErrorCategory::kIo, 2 };
+  EXPECT_TRUE(err.is_static());
+  EXPECT_EQ(err.msg(), "Cannot open file.");
+  EXPECT_EQ(err.category(), crystal::ErrorCategory::kIo);
+  EXPECT_EQ(err.code(), 2);
+}
+
+TEST(ErrorTest, FixedStringMessage) {
+  constexpr auto err = crystal::Error::Make<"parse failure">(
+      crystal::ErrorCategory::kParse, 7);
+  static_assert(err.msg() == "parse failure");
+  EXPECT_TRUE(err.is_static());
+  EXPECT_EQ(err.code(), 7);
+}
+
+TEST(ErrorTest, InlineMessage) {
+  std::string ctx = "line 42";
+  auto err = crystal::Error::Inline(ctx);
+  ctx.clear(); // the message is a copy
+  EXPECT_FALSE(err.is_static());
+  EXPECT_EQ(err.msg(), "line 42");
+
+  std::string long_ctx(100, 'x');
+  auto truncated = crystal::Error::Inline(long_ctx);
+  EXPECT_EQ(truncated.msg().size(), crystal::Error::kInlineCapacity);
+}
+
+TEST(ErrorTest, EqualityIgnoresMessage) {
+  const crystal::Error a{ "first", crystal::ErrorCategory::kParse, 3 };
+  EXPECT_EQ(a, (crystal::Error{ "second", crystal::ErrorCategory::kParse, 3 }));
+  EXPECT_NE(a, (crystal::Error{ "first", crystal::ErrorCategory::kParse, 4 }));
+  EXPECT_NE(a, (crystal::Error{ "first", crystal::ErrorCategory::kIo, 3 }));
+}
+
+TEST(ErrorTest, Layout) {
+  EXPECT_TRUE(std::is_trivially_copyable_v<crystal::Error>);
+  EXPECT_LE(sizeof(crystal::Error), 32);
+}
+
+TEST(ErrorTest, ReadFileFailure) {
+  auto res = crystal::ReadFile("/nonexistent/crystal_base_file");
+  ASSERT_FALSE(res.has_value());
+  EXPECT_EQ(res.error().category(), crystal::ErrorCategory::kSystem);
+  EXPECT_EQ(res.error().code(), ENOENT);
+  EXPECT_EQ(res.error().msg(), "Cannot open file.");
+}
@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "CrystalBase/flat_hash_map.h"
+#include "CrystalBase/inline_string.h"
+#include "CrystalBase/strict_index.h"
+
+namespace {
+
+/* Sends every key to the same group, to exercise probing and tombstones. */
+struct CollidingHash {
+  size_t operator()(int) const {
+    return 0;
+  }
+};
+
+/* A key that is not trivially relocatable and counts its copies. */
+struct TrackedKey {
+  static inline int copies = 0;
+
+  explicit TrackedKey(int n) : name{ std::to_string(n) } {
+  }
+  TrackedKey(const TrackedKey& other) : name{ other.name } {
+    ++copies;
+  }
+  TrackedKey(TrackedKey&&) noexcept = default;
+  bool operator==(const TrackedKey&) const = default;
+
+  std::string name;
+};
+/* A move-only key that is not trivially relocatable. */
+struct MoveOnlyKey {
+  explicit MoveOnlyKey(int n) : name{ std::to_string(n) } {
+  }
+  MoveOnlyKey(const MoveOnlyKey&) = delete;
+  MoveOnlyKey(MoveOnlyKey&&) noexcept = default;
+  bool operator==(const MoveOnlyKey&) const = default;
+
+  std::string name;
+};
+struct NameHash {
+  template <typename Key>
+  size_t operator()(const Key& key) const {
+    return std::hash<std::string>{}(key.name);
+  }
+};
+
+/* Movable only by copying, which throws once `budget` copies are spent. */
+struct ThrowingCopy {
+  static inline int budget = -1;
+  static inline int live = 0;
+
+  explicit ThrowingCopy(int n) : n{ n } {
+    ++live;
+  }
+  ThrowingCopy(const ThrowingCopy& other) : n{ other.n } {
+    if (budget == 0) throw std::runtime_error{ "copy" };
+    --budget;
+    ++live;
+  }
+  ~ThrowingCopy() {
+    --live;
+  }
+
+  int n;
+};
+
+} // namespace
+
+TEST(FlatHashMap, InsertFind) {
+  crystal::flat_hash_map<int, int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.find(1), map.end());
+  EXPECT_TRUE(map.insert({ 1, 10 }).second);
+  EXPECT_FALSE(map.insert({ 1, 20 }).second);
+  EXPECT_TRUE(map.emplace(2, 20).second);
+  EXPECT_TRUE(map.try_emplace(3, 30).second);
+  EXPECT_EQ(map.size(), 3);
+  EXPECT_EQ(map.at(1), 10);
+  EXPECT_EQ(map.find(2)->second, 20);
+  EXPECT_TRUE(map.contains(3));
+  EXPECT_FALSE(map.contains(4));
+  EXPECT_EQ(map.count(4), 0);
+  EXPECT_THROW((void)map.at(4), std::out_of_range);
+  map[4] += 40;
+  EXPECT_EQ(map[4], 40);
+  EXPECT_FALSE(map.insert_or_assign(4, 41).second);
+  EXPECT_EQ(map[4], 41);
+}
+
+TEST(FlatHashMap, GrowMatchesStd) {
+  crystal::flat_hash_map<uint64_t, uint64_t> map;
+  std::unordered_map<uint64_t, uint64_t> ref;
+  std::mt19937_64 rng{ 7 };
+  for (int i = 0; i < 20000; ++i) {
+    uint64_t key = rng() % 5000;
+    switch (rng() % 3) {
+    case 0:
+      map[key] = i;
+      ref[key] = i;
+      break;
+    case 1:
+      EXPECT_EQ(map.erase(key), ref.erase(key));
+      break;
+    default:
+      EXPECT_EQ(map.contains(key), ref.contains(key));
+    }
+  }
+  EXPECT_EQ(map.size(), ref.size());
+  EXPECT_LE(map.load_factor(), map.max_load_factor());
+  size_t visited = 0;
+  for (const auto& [key, value] : map) {
+    EXPECT_EQ(ref.at(key), value);
+    ++visited;
+  }
+  EXPECT_EQ(visited, ref.size());
+}
+
+TEST(FlatHashMap, Collisions) {
+  crystal::flat_hash_map<int, int, CollidingHash> map;
+  for (int i = 0; i < 100; ++i) map[i] = i;
+  for (int i = 0; i < 100; i += 2) EXPECT_EQ(map.erase(i), 1);
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(map.contains(i), i % 2 == 1);
+  /* Churn through tombstones without growing without bound. */
+  for (int i = 100; i < 10000; ++i) {
+    map[i] = i;
+    map.erase(i);
+  }
+  EXPECT_EQ(map.size(), 50);
+  EXPECT_LE(map.capacity(), 256);
+}
+
+TEST(FlatHashMap, HeterogeneousLookup) {
+  crystal::flat_hash_map<std::string, int> map;
+  map["alpha"] = 1;
+  map.try_emplace(std::string(40, 'x'), 2);
+  std::string_view view = "alpha";
+  EXPECT_EQ(map.find(view)->second, 1);
+  EXPECT_EQ(map.at(std::string_view(std::string(40, 'x'))), 2);
+  EXPECT_TRUE(map.contains("alpha"));
+  EXPECT_EQ(map.erase(view), 1);
+  EXPECT_FALSE(map.contains(view));
+
+  crystal::flat_hash_set<crystal::inline_string<16>> set{ "a", "bc" };
+  EXPECT_TRUE(set.contains(std::string_view("bc")));
+  EXPECT_FALSE(set.contains(std::string_view("b")));
+}
+
+TEST(FlatHashMap, EraseIterator) {
+  crystal::flat_hash_map<int, std::string> map;
+  for (int i = 0; i < 64; ++i) map.emplace(i, std::to_string(i));
+  for (auto it = map.begin(); it != map.end();) {
+    if (it->first % 3 == 0) {
+      it = map.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  EXPECT_EQ(map.size(), 42);
+  for (const auto& [key, value] : map) {
+    EXPECT_NE(key % 3, 0);
+    EXPECT_EQ(value, std::to_string(key));
+  }
+}
+
+TEST(FlatHashMap, CopyMove) {
+  crystal::flat_hash_map<std::string, std::string> map;
+  for (int i = 0; i < 100; ++i) map[std::to_string(i)] = std::to_string(i * i);
+  auto copy = map;
+  EXPECT_EQ(copy, map);
+  auto moved = std::move(copy);
+  EXPECT_EQ(moved, map);
+  EXPECT_TRUE(copy.empty());
+  moved["0"] = "x";
+  EXPECT_NE(moved, map);
+  copy = moved;
+  EXPECT_EQ(copy.at("0"), "x");
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  map.swap(copy);
+  EXPECT_EQ(map.size(), 100);
+}
+
+TEST(FlatHashMap, Pmr) {
+  std::pmr::monotonic_buffer_resource pool;
+  crystal::pmr::flat_hash_map<int, int> map{ &pool };
+  for (int i = 0; i < 100; ++i) map[i] = i;
+  EXPECT_EQ(map.get_allocator().resource(), &pool);
+
+  /* Different resources: the move must transfer the elements one by one. */
+  std::pmr::monotonic_buffer_resource other;
+  crystal::pmr::flat_hash_map<int, int> moved{ std::move(map), &other };
+  EXPECT_EQ(moved.size(), 100);
+  EXPECT_EQ(moved.at(42), 42);
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(FlatHashMap, GrowMovesKeys) {
+  crystal::flat_hash_map<TrackedKey, std::unique_ptr<int>, NameHash> map;
+  for (int i = 0; i < 1000; ++i) {
+    map.try_emplace(TrackedKey{ i }, std::make_unique<int>(i));
+  }
+  EXPECT_EQ(TrackedKey::copies, 0);
+  EXPECT_EQ(*map.find(TrackedKey{ 567 })->second, 567);
+
+  crystal::flat_hash_map<MoveOnlyKey, int, NameHash> owners;
+  for (int i = 0; i < 100; ++i) owners.try_emplace(MoveOnlyKey{ i }, i);
+  EXPECT_EQ(owners.find(MoveOnlyKey{ 42 })->second, 42);
+}
+
+TEST(FlatHashMap, ThrowingGrowLeavesMapIntact) {
+  {
+    crystal::flat_hash_map<int, ThrowingCopy> map;
+    for (int i = 0; map.size() < map.capacity() * 7 / 8; ++i) {
+      map.emplace(i, ThrowingCopy{ i });
+    }
+    const size_t size = map.size();
+    const size_t capacity = map.capacity();
+    ThrowingCopy::budget = static_cast<int>(size / 2);
+    EXPECT_THROW(map.emplace(-1, ThrowingCopy{ -1 }), std::runtime_error);
+    ThrowingCopy::budget = -1;
+    EXPECT_EQ(map.size(), size);
+    EXPECT_EQ(map.capacity(), capacity);
+    EXPECT_EQ(ThrowingCopy::live, static_cast<int>(size));
+    for (int i = 0; i < static_cast<int>(size); ++i) {
+      EXPECT_EQ(map.find(i)->second.n, i);
+    }
+  }
+  EXPECT_EQ(ThrowingCopy::live, 0);
+}
+
+TEST(FlatHashSet, Basic) {
+  struct Tag {};
+  using Idx = crystal::StrictIdx<Tag, uint32_t>;
+  crystal::flat_hash_set<Idx> set;
+  for (uint32_t i = 0; i < 1000; ++i) EXPECT_TRUE(set.insert(Idx{ i }).second);
+  EXPECT_FALSE(set.emplace(Idx{ 5 }).second);
+  EXPECT_EQ(set.size(), 1000);
+  EXPECT_TRUE(set.contains(Idx{ 999 }));
+  EXPECT_EQ(set.erase(Idx{ 999 }), 1);
+  EXPECT_FALSE(set.contains(Idx{ 999 }));
+  set.rehash(0);
+  EXPECT_EQ(set.size(), 999);
+  EXPECT_TRUE(set.contains(Idx{ 0 }));
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <format>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+#include "CrystalBase/fixed_string.h"
+#include "CrystalBase/inline_string.h"
+
+TEST(InlineStringTest, ConstructionAndAccess) {
+  crystal::inline_string<16> str = "hello";
+  EXPECT_EQ(str.size(), 5);
+  EXPECT_EQ(str, "hello");
+  EXPECT_EQ(str[1], 'e');
+  EXPECT_EQ(str.front(), 'h');
+  EXPECT_EQ(str.back(), 'o');
+  EXPECT_EQ(std::string(str.begin(), str.end()), "hello");
+  EXPECT_TRUE(crystal::inline_string<4>{}.empty());
+  EXPECT_TRUE(std::is_trivially_copyable_v<crystal::inline_string<16>>);
+  EXPECT_EQ(sizeof(crystal::inline_string<15>), 16);
+}
+
+TEST(InlineStringTest, AppendTruncates) {
+  crystal::inline_string<8> str;
+  EXPECT_TRUE(str.append("abc"));
+  EXPECT_TRUE(str.push_back('d'));
+  str += "ef";
+  EXPECT_EQ(str, "abcdef");
+  EXPECT_FALSE(str.append("ghij"));
+  EXPECT_EQ(str, "abcdefgh");
+  EXPECT_FALSE(str.push_back('x'));
+  str.pop_back();
+  str.resize(3);
+  EXPECT_EQ(str, "abc");
+  crystal::inline_string<4> truncated{ std::string_view{ "too long" } };
+  EXPECT_EQ(truncated, "too ");
+}
+
+TEST(InlineStringTest, StringViewOperations) {
+  crystal::inline_string<32> str = "key=value";
+  EXPECT_EQ(str.find('='), 3);
+  EXPECT_EQ(str.substr(4), "value");
+  EXPECT_TRUE(str.starts_with("key"));
+  EXPECT_TRUE(str.ends_with("value"));
+  EXPECT_TRUE(str.contains("=v"));
+  std::string_view view = str;
+  EXPECT_EQ(view, "key=value");
+}
+
+TEST(InlineStringTest, Comparison) {
+  crystal::inline_string<16> a = "abc";
+  crystal::inline_string<16> b{ std::string_view{ "abcdef" } };
+  b.resize(3);
+  EXPECT_EQ(a, b); // stale chars past size() are ignored
+  EXPECT_LT(a, crystal::inline_string<16>{ "abd" });
+  EXPECT_EQ(std::string_view{ "abc" }, a);
+}
+
+TEST(InlineStringTest, FixedStringConversion) {
+  constexpr crystal::fixed_string fs{ "crystal" };
+  constexpr crystal::inline_string<16> str = fs;
+  static_assert(str.size() == 7);
+  EXPECT_EQ(str.to_fixed_string<7>(), fs);
+}
+
+TEST(InlineStringTest, HashAndOutput) {
+  crystal::inline_string<16> str = "crystal";
+  EXPECT_EQ(std::hash<crystal::inline_string<16>>{}(str),
+            crystal::StringHash{}(std::string_view{ "crystal" }));
+  EXPECT_EQ(std::hash<crystal::inline_string<16>>{}(str),
+            std::hash<crystal::fixed_string<7>>{}("crystal"));
+
+  std::unordered_map<crystal::inline_string<16>, int> map;
+  map[str] = 1;
+  map[crystal::inline_string<16>{ "other" }] = 2;
+  EXPECT_EQ(map.at(crystal::inline_string<16>{ "crystal" }), 1);
+
+  std::ostringstream os;
+  os << str;
+  EXPECT_EQ(os.str(), "crystal");
+}
+
+TEST(InlineStringTest, Format) {
+  const crystal::inline_string<16> str = "crystal";
+  EXPECT_EQ(std::format("{}", str), "crystal");
+  EXPECT_EQ(std::format("[{}]", crystal::inline_string<4>{}), "[]");
+}
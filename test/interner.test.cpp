@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "CrystalBase/interner.h"
+
+TEST(InternerTest, DenseIds) {
+  crystal::Interner interner;
+  auto a = interner.intern("alpha");
+  auto b = interner.intern("beta");
+  EXPECT_EQ(a.get(), 0);
+  EXPECT_EQ(b.get(), 1);
+  EXPECT_EQ(interner.intern("alpha"), a);
+  EXPECT_EQ(interner.size(), 2);
+  EXPECT_EQ(interner.str(a), "alpha");
+  EXPECT_EQ(interner.str(b), "beta");
+}
+
+TEST(InternerTest, UnknownIds) {
+  crystal::Interner interner;
+  EXPECT_EQ(interner.str(crystal::SymbolId{}), "");
+  EXPECT_EQ(interner.str(5), "");
+  interner.intern("only");
+  EXPECT_EQ(interner.str(1), "");
+  EXPECT_EQ(interner.str(1u << 20), "");
+}
+
+TEST(InternerTest, Find) {
+  crystal::Interner interner;
+  EXPECT_EQ(interner.find("missing").get(), crystal::SymbolId::nullvalue);
+  auto id = interner.intern(std::string{ "present" });
+  EXPECT_EQ(interner.find("present"), id);
+  auto empty = interner.intern("");
+  EXPECT_EQ(interner.find(""), empty);
+  EXPECT_EQ(interner.str(empty), "");
+}
+
+TEST(InternerTest, GrowthKeepsStrings) {
+  crystal::Interner interner;
+  std::vector<crystal::SymbolId> ids;
+  for (int i = 0; i < 5000; ++i) ids.push_back(interner.intern(std::to_string(i)));
+  for (int i = 0; i < 5000; ++i) {
+    EXPECT_EQ(ids[i].get(), static_cast<uint32_t>(i));
+    EXPECT_EQ(interner.str(ids[i]), std::to_string(i));
+    EXPECT_EQ(interner.intern(std::to_string(i)), ids[i]);
+  }
+}
+
+TEST(InternerTest, ConcurrentIntern) {
+  crystal::Interner interner;
+  constexpr int kThreads = 4, kStrings = 2000;
+  std::vector<std::vector<crystal::SymbolId>> ids(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kStrings; ++i) {
+        ids[t].push_back(interner.intern("sym" + std::to_string(i)));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(interner.size(), kStrings);
+  for (int t = 1; t < kThreads; ++t) EXPECT_EQ(ids[t], ids[0]);
+}
+
+TEST(InternerTest, ConcurrentReaders) {
+  crystal::Interner interner;
+  constexpr int kThreads = 4, kStrings = 2000;
+  std::atomic<bool> done = false;
+  std::thread reader{ [&] {
+    while (!done.load(std::memory_order_relaxed)) {
+      /* An id resolves to its whole string, or to nothing while in flight. */
+      const size_t n = interner.size();
+      for (size_t id = n > 8 ? n - 8 : 0; id < n + 8; ++id) {
+        std::string_view str = interner.str(static_cast<uint32_t>(id));
+        if (!str.empty()) EXPECT_EQ(str[0], 't');
+      }
+    }
+  } };
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kStrings; ++i) {
+        interner.intern("t" + std::to_string(t) + "_" + std::to_string(i));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  done = true;
+  reader.join();
+  EXPECT_EQ(interner.size(), kThreads * kStrings);
+  for (uint32_t id = 0; id < kThreads * kStrings; ++id) {
+    EXPECT_FALSE(interner.str(id).empty());
+  }
+}
+
+TEST(InternerTest, LiteralSymbols) {
+  auto a = crystal::intern<"interner_test_literal">();
+  EXPECT_EQ(a, crystal::intern<"interner_test_literal">());
+  EXPECT_EQ(a, crystal::intern("interner_test_literal"));
+  EXPECT_EQ(crystal::Interner::Global().str(a), "interner_test_literal");
+
+  std::unordered_set<crystal::SymbolId> set{ a };
+  EXPECT_TRUE(set.contains(crystal::intern("interner_test_literal")));
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CrystalBase/log.h"
+
+namespace {
+
+enum class Color : uint8_t { kRed = 1, kBlue = 7 };
+
+/* Flush and split into messages, the `[time] [thread] ` prefix removed. */
+std::vector<std::string> Messages() {
+  std::ostringstream os;
+  crystal::FlushLogs(os);
+  std::istringstream is{ os.str() };
+  std::vector<std::string> messages;
+  for (std::string line; std::getline(is, line);) {
+    messages.push_back(line.substr(line.find("] ", line.find("] ") + 2) + 2));
+  }
+  return messages;
+}
+
+/* A stream buffer whose writer blocks until the gate opens. */
+class GateBuf : public std::streambuf {
+ public:
+  std::atomic<bool> entered = false;
+  std::atomic<bool> open = false;
+
+ protected:
+  int_type overflow(int_type c) override {
+    entered = true;
+    while (!open) std::this_thread::yield();
+    return c;
+  }
+};
+
+} // namespace
+
+TEST(LogTest, CompileTimeSites) {
+  using crystal::LogSite;
+  static_assert(LogSite<"{}", int>::kId != LogSite<"{}", long long>::kId);
+  static_assert(LogSite<"{}", int>::kId != LogSite<"{} ", int>::kId);
+  static_assert(crystal::count_placeholders<"a {} b {}{}">() == 3);
+  static_assert(crystal::count_placeholders<"none">() == 0);
+}
+
+TEST(LogTest, FormatsArguments) {
+  Messages(); // drop anything logged before
+  const std::string owned = "owned";
+  crystal::Log<"plain">();
+  crystal::Log<"x = {}, y = {}">(1, -2.5);
+  crystal::Log<"{} {} {}">("literal", std::string_view{ "view" }, owned);
+  crystal::Log<"{}|{}|{}">(true, 'c', Color::kBlue);
+  crystal::Log<"{} {}">(uint64_t{ 18446744073709551615ull }, int8_t{ -8 });
+  crystal::Log<"{}">(reinterpret_cast<const void*>(uintptr_t{ 0xbeef }));
+  crystal::Log<"trailing {}.">(std::string(300, 'z').substr(0, 3));
+  crystal::Log<"null {}">(static_cast<const char*>(nullptr));
+
+  EXPECT_EQ(Messages(),
+            (std::vector<std::string>{
+                "plain",
+                "x = 1, y = -2.5",
+                "literal view owned",
+                "true|c|7",
+                "18446744073709551615 -8",
+                "0xbeef",
+                "trailing zzz.",
+                "null (null)",
+            }));
+  EXPECT_TRUE(Messages().empty()); // consumed by the flush
+}
+
+TEST(LogTest, ThreadsInTimestampOrder) {
+  Messages();
+  constexpr int kThreads = 4;
+  constexpr int kPerThread = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([t] {
+      for (int i = 0; i < kPerThread; ++i) crystal::Log<"{} {}">(t, i);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  std::ostringstream os;
+  crystal::FlushLogs(os);
+  std::istringstream is{ os.str() };
+  std::vector<int> next(kThreads, 0);
+  double last = 0;
+  int lines = 0;
+  for (std::string line; std::getline(is, line); ++lines) {
+    const double time = std::stod(line.substr(1));
+    EXPECT_LE(last, time);
+    last = time;
+    std::istringstream message{ line.substr(line.rfind("] ") + 2) };
+    int t, i;
+    message >> t >> i;
+    ASSERT_TRUE(t >= 0 && t < kThreads);
+    EXPECT_EQ(i, next[t]++); // in order per thread
+  }
+  EXPECT_EQ(lines, kThreads * kPerThread);
+}
+
+TEST(LogTest, DropsWhenFull) {
+  Messages();
+  const uint64_t dropped = crystal::LogDropped();
+  const std::string payload(1000, 'x');
+  const size_t n = crystal::LogBuffer::kCapacity / 1000 + 10;
+  for (size_t i = 0; i < n; ++i) crystal::Log<"{}">(payload);
+  EXPECT_GT(crystal::LogDropped(), dropped);
+
+  /* The buffer takes records again once drained, wrapping around. */
+  const size_t kept = Messages().size();
+  EXPECT_EQ(kept + (crystal::LogDropped() - dropped), n);
+  for (size_t i = 0; i < n / 2; ++i) crystal::Log<"{}">(payload);
+  EXPECT_EQ(Messages().size(), n / 2);
+}
+
+TEST(LogTest, DropsOversized) {
+  Messages();
+  const uint64_t dropped = crystal::LogDropped();
+  const std::string payload(crystal::LogBuffer::kCapacity, 'x');
+  crystal::Log<"{}">(payload);
+  EXPECT_EQ(crystal::LogDropped(), dropped + 1);
+  EXPECT_TRUE(Messages().empty());
+}
+
+TEST(LogTest, ReleasesBuffersOfExitedThreads) {
+  Messages();
+  const size_t buffers = crystal::LogRegistry::Instance().buffer_count();
+  const uint64_t dropped = crystal::LogDropped();
+  const std::string payload(crystal::LogBuffer::kCapacity, 'x');
+  for (int i = 0; i < 16; ++i) {
+    std::thread{ [&] {
+      crystal::Log<"churn {}">(i);
+      crystal::Log<"{}">(payload);
+    } }.join();
+  }
+  EXPECT_EQ(Messages().size(), 16);
+  EXPECT_EQ(crystal::LogRegistry::Instance().buffer_count(), buffers);
+  /* Drops of released buffers are still counted. */
+  EXPECT_EQ(crystal::LogDropped(), dropped + 16);
+}
+
+TEST(LogTest, SlowFlushDoesNotBlockLogging) {
+  Messages();
+  crystal::Log<"before the flush">();
+  GateBuf gate;
+  std::ostream os{ &gate };
+  std::thread flusher{ [&] { crystal::FlushLogs(os); } };
+  while (!gate.entered) std::this_thread::yield();
+
+  /* A new thread registers its buffer while the flush is writing. */
+  std::thread{ [] { crystal::Log<"during the flush">(); } }.join();
+  gate.open = true;
+  flusher.join();
+  EXPECT_EQ(Messages(), (std::vector<std::string>{ "during the flush" }));
+}
+
+TEST(LogTest, Writer) {
+  Messages();
+  std::ostringstream os;
+  {
+    crystal::LogWriter writer{ os, std::chrono::milliseconds{ 1 } };
+    crystal::Log<"from {}">("writer");
+  }
+  EXPECT_NE(os.str().find("from writer"), std::string::npos);
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "CrystalBase/small_vector.h"
+#include "CrystalBase/static_vector.h"
+
+namespace {
+
+constexpr int ConstexprSum() {
+  crystal::static_vector<int, 8> v{ 1, 2, 3 };
+  v.push_back(4);
+  v.erase(v.begin());
+  v.insert(v.begin(), 10);
+  int sum = 0;
+  for (int x : v) sum += x;
+  return sum;
+}
+
+constexpr crystal::static_vector<int, 4> kTable{ 7, 8 };
+
+/* Counts live objects to check construction/destruction pairing. */
+struct Tracked {
+  static inline int live = 0;
+  std::string value;
+  explicit Tracked(std::string v) : value(std::move(v)) {
+    ++live;
+  }
+  Tracked(const Tracked& other) : value(other.value) {
+    ++live;
+  }
+  Tracked(Tracked&& other) noexcept : value(std::move(other.value)) {
+    ++live;
+  }
+  Tracked& operator=(const Tracked&) = default;
+  Tracked& operator=(Tracked&&) = default;
+  ~Tracked() {
+    --live;
+  }
+  bool operator==(const Tracked&) const = default;
+};
+
+/* Copied, never moved; copies throw once `budget` of them are spent. */
+struct ThrowingCopy {
+  static inline int budget = -1;
+  static inline int live = 0;
+  int n;
+  explicit ThrowingCopy(int n) : n{ n } {
+    ++live;
+  }
+  ThrowingCopy(const ThrowingCopy& other) : n{ other.n } {
+    if (budget == 0) throw std::runtime_error{ "copy" };
+    --budget;
+    ++live;
+  }
+  ~ThrowingCopy() {
+    --live;
+  }
+};
+
+} // namespace
+
+TEST(StaticVectorTest, Constexpr) {
+  static_assert(ConstexprSum() == 19);
+  static_assert(kTable.size() == 2 && kTable[1] == 8);
+  EXPECT_TRUE((std::is_trivially_copyable_v<crystal::static_vector<int, 4>>));
+}
+
+TEST(StaticVectorTest, CapacityExhaustion) {
+  crystal::static_vector<int, 2> v;
+  EXPECT_NE(v.try_push_back(1), nullptr);
+  EXPECT_NE(v.try_push_back(2), nullptr);
+  EXPECT_TRUE(v.full());
+  EXPECT_EQ(v.try_push_back(3), nullptr);
+  EXPECT_THROW(v.push_back(3), std::bad_alloc);
+  EXPECT_EQ(v.size(), 2);
+}
+
+TEST(StaticVectorTest, NonTrivialElements) {
+  {
+    crystal::static_vector<Tracked, 4> v;
+    v.emplace_back("a");
+    v.emplace_back("b");
+    v.insert(v.begin(), Tracked{ "c" });
+    EXPECT_EQ(v[0].value, "c");
+    EXPECT_EQ(v[2].value, "b");
+    auto copy = v;
+    auto moved = std::move(v);
+    EXPECT_EQ(moved.size(), 3);
+    EXPECT_EQ(copy, copy);
+    moved.erase(moved.begin());
+    EXPECT_EQ(moved[0].value, "a");
+  }
+  EXPECT_EQ(Tracked::live, 0);
+}
+
+TEST(SmallVectorTest, InlineThenSpill) {
+  crystal::small_vector<int, 4> v;
+  for (int i = 0; i < 4; ++i) v.push_back(i);
+  EXPECT_TRUE(v.is_inline());
+  EXPECT_EQ(v.capacity(), 4);
+  v.push_back(4);
+  EXPECT_FALSE(v.is_inline());
+  for (int i = 0; i < 5; ++i) EXPECT_EQ(v[i], i);
+  v.resize(2);
+  v.shrink_to_fit();
+  EXPECT_TRUE(v.is_inline());
+  EXPECT_EQ(v[1], 1);
+}
+
+TEST(SmallVectorTest, PushBackAliasingElement) {
+  crystal::small_vector<std::string, 2> v{ "x", "y" };
+  v.push_back(v[0]); // grows while referencing an element
+  EXPECT_EQ(v[2], "x");
+}
+
+TEST(SmallVectorTest, MoveSemantics) {
+  crystal::small_vector<std::unique_ptr<int>, 2> small;
+  small.push_back(std::make_unique<int>(1));
+  auto moved_small = std::move(small);
+  EXPECT_EQ(*moved_small[0], 1);
+  EXPECT_TRUE(small.empty());
+
+  crystal::small_vector<std::unique_ptr<int>, 2> big;
+  for (int i = 0; i < 8; ++i) big.push_back(std::make_unique<int>(i));
+  const int* heap = big.data()->get();
+  auto moved_big = std::move(big);
+  EXPECT_EQ(moved_big.size(), 8);
+  EXPECT_EQ(moved_big.data()->get(), heap);
+  EXPECT_TRUE(big.empty());
+  EXPECT_TRUE(big.is_inline());
+
+  static_assert(crystal::is_trivially_relocatable_v<std::unique_ptr<int>>);
+  /* Move assignment from an inline source moves each element. */
+  struct ThrowingMove {
+    ThrowingMove() = default;
+    ThrowingMove(const ThrowingMove&) = default;
+    ThrowingMove(ThrowingMove&&) noexcept(false) {}
+  };
+  static_assert(std::is_nothrow_move_assignable_v<
+                crystal::small_vector<std::unique_ptr<int>, 2>>);
+  static_assert(!std::is_nothrow_move_assignable_v<
+                crystal::small_vector<ThrowingMove, 2>>);
+}
+
+TEST(SmallVectorTest, ElementLifetimes) {
+  {
+    crystal::small_vector<Tracked, 2> v;
+    for (int i = 0; i < 6; ++i) v.emplace_back(std::to_string(i));
+    v.erase(v.begin() + 1, v.begin() + 3);
+    EXPECT_EQ(v.size(), 4);
+    EXPECT_EQ(v[1].value, "3");
+    crystal::small_vector<Tracked, 2> other;
+    other = v;
+    other = std::move(v);
+    EXPECT_EQ(other.size(), 4);
+  }
+  EXPECT_EQ(Tracked::live, 0);
+}
+
+TEST(SmallVectorTest, ThrowingCopies) {
+  {
+    crystal::small_vector<ThrowingCopy, 2> v;
+    for (int i = 0; i < 4; ++i) v.emplace_back(i);
+    ASSERT_EQ(v.capacity(), 4);
+
+    /* Growing: the new element and half the relocation succeed. */
+    ThrowingCopy::budget = 2;
+    EXPECT_THROW(v.emplace_back(4), std::runtime_error);
+    EXPECT_EQ(v.size(), 4);
+    EXPECT_EQ(v.capacity(), 4);
+    EXPECT_EQ(v[3].n, 3);
+    EXPECT_EQ(ThrowingCopy::live, 4);
+
+    ThrowingCopy::budget = 1;
+    EXPECT_THROW(v.reserve(16), std::runtime_error);
+    EXPECT_EQ(v.capacity(), 4);
+    EXPECT_EQ(ThrowingCopy::live, 4);
+
+    ThrowingCopy::budget = -1;
+    v.reserve(8);
+    ThrowingCopy::budget = 2;
+    EXPECT_THROW(v.resize(8, ThrowingCopy{ 9 }), std::runtime_error);
+    EXPECT_EQ(v.size(), 6);
+    EXPECT_EQ(ThrowingCopy::live, 6);
+
+    ThrowingCopy::budget = 3;
+    EXPECT_THROW(auto copy = v, std::runtime_error);
+
+    crystal::static_vector<ThrowingCopy, 8> s;
+    for (int i = 0; i < 4; ++i) s.emplace_back(i);
+    ThrowingCopy::budget = 2;
+    EXPECT_THROW(auto copy = s, std::runtime_error);
+    ThrowingCopy::budget = -1;
+  }
+  EXPECT_EQ(ThrowingCopy::live, 0);
+}
+
+TEST(SmallVectorTest, PMRAllocatorUsage) {
+  std::array<std::byte, 1024> buffer;
+  std::pmr::monotonic_buffer_resource res{ buffer.data(),
+                                           buffer.size(),
+                                           std::pmr::null_memory_resource() };
+  crystal::pmr::small_vector<int, 4> v{ &res };
+  for (int i = 0; i < 4; ++i) v.push_back(i);
+  EXPECT_TRUE(v.is_inline());
+  for (int i = 4; i < 32; ++i) v.push_back(i);
+  EXPECT_EQ(v.get_allocator().resource(), &res);
+  EXPECT_GE(v.data(), reinterpret_cast<int*>(buffer.data()));
+  EXPECT_LT(v.data(), reinterpret_cast<int*>(buffer.data() + buffer.size()));
+}
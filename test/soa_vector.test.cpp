@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+#include "CrystalBase/soa_vector.h"
+
+namespace {
+
+struct Vec3 {
+  float x, y, z;
+  bool operator==(const Vec3&) const = default;
+};
+
+using Particles = crystal::soa_vector<crystal::field<"pos", Vec3>,
+                                      crystal::field<"vel", Vec3>,
+                                      crystal::field<"id", uint32_t>>;
+
+bool Aligned(const void* ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) % Particles::kColumnAlignment == 0;
+}
+
+} // namespace
+
+TEST(SoaVector, Columns) {
+  Particles particles;
+  for (uint32_t i = 0; i < 100; ++i) {
+    particles.emplace_back(Vec3{ 1.0f * i, 0, 0 }, Vec3{ 0, 1, 0 }, i);
+  }
+  EXPECT_EQ(particles.size(), 100);
+
+  auto pos = particles.get<"pos">();
+  auto ids = particles.get<"id">();
+  static_assert(std::is_same_v<decltype(ids), std::span<uint32_t>>);
+  EXPECT_EQ(pos.size(), 100);
+  EXPECT_EQ(ids[42], 42);
+  EXPECT_EQ(pos[42].x, 42.0f);
+  EXPECT_TRUE(Aligned(pos.data()));
+  EXPECT_TRUE(Aligned(particles.get<"vel">().data()));
+  EXPECT_TRUE(Aligned(ids.data()));
+
+  /* A sweep over one column. */
+  for (auto& [x, y, z] : particles.get<"pos">()) x += 1.0f;
+  EXPECT_EQ(particles[0].get<"pos">().x, 1.0f);
+
+  const Particles& view = particles;
+  static_assert(std::is_same_v<decltype(view.get<"id">()),
+                               std::span<const uint32_t>>);
+  EXPECT_EQ(view.get<2>()[99], 99);
+}
+
+TEST(SoaVector, Rows) {
+  Particles particles;
+  particles.push_back({ Vec3{ 1, 2, 3 }, Vec3{}, 7 });
+  particles.push_back({ Vec3{ 4, 5, 6 }, Vec3{}, 8 });
+
+  auto row = particles[1];
+  EXPECT_EQ(row.index(), 1);
+  EXPECT_EQ(row.get<"id">(), 8);
+  row.get<"vel">() = Vec3{ 1, 1, 1 };
+  EXPECT_EQ(particles.get<"vel">()[1], (Vec3{ 1, 1, 1 }));
+
+  /* Rows assign values, not proxies. */
+  particles[0] = particles[1];
+  EXPECT_EQ(particles.get<"id">()[0], 8);
+  std::tuple<Vec3, Vec3, uint32_t> copy = particles[0];
+  EXPECT_EQ(std::get<2>(copy), 8);
+
+  uint32_t sum = 0;
+  for (auto r : particles) sum += r.get<"id">();
+  EXPECT_EQ(sum, 16);
+  EXPECT_EQ(particles.end() - particles.begin(), 2);
+  EXPECT_THROW((void)particles.at(2), std::out_of_range);
+}
+
+TEST(SoaVector, EraseKeepsColumnsAligned) {
+  crystal::soa_vector<crystal::field<"name", std::string>,
+                      crystal::field<"rank", int>>
+      table;
+  for (int i = 0; i < 10; ++i) table.emplace_back(std::to_string(i), i);
+
+  table.erase(2);
+  EXPECT_EQ(table.size(), 9);
+  EXPECT_EQ(table.get<"name">()[2], "3");
+  EXPECT_EQ(table.get<"rank">()[2], 3);
+
+  table.swap_erase(0);
+  EXPECT_EQ(table.size(), 8);
+  EXPECT_EQ(table.get<"name">()[0], "9");
+  EXPECT_EQ(table.get<"rank">()[0], 9);
+
+  table.pop_back();
+  EXPECT_EQ(table.back().get<"name">(), "7");
+
+  auto copy = table;
+  table.clear();
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(copy.size(), 7);
+  EXPECT_EQ(copy.get<"name">()[1], "1");
+
+  copy.resize(10);
+  EXPECT_EQ(copy.get<"name">()[9], "");
+  EXPECT_EQ(copy.get<"rank">()[9], 0);
+  copy.shrink_to_fit();
+  EXPECT_EQ(copy.capacity(), 10);
+  EXPECT_EQ(copy.get<"name">()[1], "1");
+}
+
+TEST(SoaVector, ResizeDownAndSelfReference) {
+  crystal::soa_vector<crystal::field<"name", std::string>,
+                      crystal::field<"rank", int>>
+      table;
+  for (int i = 0; i < 8; ++i) {
+    table.emplace_back(std::string(40, static_cast<char>('a' + i)), i);
+  }
+  /* Shrinking destroys the tail rows exactly once. */
+  table.resize(3);
+  EXPECT_EQ(table.size(), 3);
+  EXPECT_EQ(table.get<"name">()[2], std::string(40, 'c'));
+  table.resize(5);
+  EXPECT_EQ(table.get<"name">()[4], "");
+
+  /* Appending a copy of a row while the columns grow. */
+  table.shrink_to_fit();
+  ASSERT_EQ(table.size(), table.capacity());
+  table.emplace_back(table.get<"name">()[0], table.get<"rank">()[1]);
+  EXPECT_EQ(table.get<"name">()[5], std::string(40, 'a'));
+  EXPECT_EQ(table.get<"rank">()[5], 1);
+  EXPECT_EQ(table.get<"name">()[0], std::string(40, 'a'));
+}
+
+TEST(SoaVector, Pmr) {
+  std::pmr::monotonic_buffer_resource pool;
+  crystal::pmr::soa_vector<crystal::field<"a", double>,
+                           crystal::field<"b", char>>
+      vec{ &pool };
+  for (int i = 0; i < 1000; ++i) vec.emplace_back(i * 0.5, 'x');
+  EXPECT_EQ(vec.get_allocator().resource(), &pool);
+  EXPECT_TRUE(Aligned(vec.get<"a">().data()));
+  EXPECT_TRUE(Aligned(vec.get<"b">().data()));
+
+  auto moved = std::move(vec);
+  EXPECT_TRUE(vec.empty());
+  EXPECT_EQ(moved.get<"a">()[999], 499.5);
+}
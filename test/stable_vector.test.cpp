@@ -207,4 +207,18 @@ TEST(StableVectorTest, PMRAllocatorUsage) {
     // resulted in intermediate deallocations. But we expect at least some deallocation.
     EXPECT_GT(res.deallocated_bytes, 0);
     EXPECT_GT(res.num_deallocations, 0);
-}
\ No newline at end of file
+}
+TEST(StableVectorTest, SlotOccupancy) {
+    crystal::stable_vector<int> sv;
+    size_t id0 = sv.push_back(0);
+    size_t id1 = sv.push_back(1);
+    sv.erase(id0);
+
+    EXPECT_EQ(sv.slot_count(), 2);
+    EXPECT_FALSE(sv.occupied(id0));
+    EXPECT_TRUE(sv.occupied(id1));
+
+    // Reusing the slot occupies it again
+    EXPECT_EQ(sv.insert(2), id0);
+    EXPECT_TRUE(sv.occupied(id0));
+}
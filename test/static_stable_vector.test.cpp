@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "CrystalBase/static_stable_vector.h"
+
+namespace {
+
+/* A pool built at compile time: slot 1 erased, then reused by `insert`. */
+constexpr auto kPool = [] {
+  crystal::static_stable_vector<int, 4> pool;
+  (void)pool.push_back(10);
+  (void)pool.push_back(20);
+  (void)pool.push_back(30);
+  pool.erase(1);
+  (void)pool.insert(40);
+  pool.erase(2);
+  return pool;
+}();
+static_assert(kPool[0] == 10 && kPool[1] == 40);
+static_assert(kPool.slot_count() == 3 && !kPool.occupied(2));
+
+constexpr bool ConstexprStrings() {
+  crystal::static_stable_vector<std::string, 2> sv;
+  const size_t a = *sv.emplace(3, 'a');
+  const size_t b = *sv.insert("a string too long for the inline buffer");
+  if (sv.insert("c")) return false; // full
+  sv.erase(a);
+  crystal::static_stable_vector<std::string, 2> copy = sv;
+  return *copy.insert("d") == a && copy[a] == "d" && copy[b] == sv[b];
+}
+static_assert(ConstexprStrings());
+
+/* Counts live instances; the copy of instance number `throw_at` throws. */
+struct Counted {
+  static inline int live = 0;
+  static inline int throw_at = -1;
+
+  explicit Counted(int n) : n{ n } {
+    ++live;
+  }
+  Counted(const Counted& other) : n{ other.n } {
+    if (n == throw_at) throw std::runtime_error{ "copy" };
+    ++live;
+  }
+  ~Counted() {
+    --live;
+  }
+
+  int n;
+};
+
+} // namespace
+
+TEST(StaticStableVectorTest, EraseAndReuse) {
+  crystal::static_stable_vector<int, 8> sv;
+  EXPECT_EQ(*sv.push_back(0), 0);
+  EXPECT_EQ(*sv.push_back(1), 1);
+  EXPECT_EQ(*sv.push_back(2), 2);
+  EXPECT_EQ(*sv.push_back(3), 3);
+
+  sv.erase(0);
+  sv.erase(2);
+  EXPECT_FALSE(sv.occupied(0));
+  EXPECT_TRUE(sv.occupied(1));
+  /* LIFO free list, like stable_vector. */
+  EXPECT_EQ(*sv.insert(50), 2);
+  EXPECT_EQ(*sv.insert(60), 0);
+  EXPECT_EQ(*sv.insert(70), 4);
+  EXPECT_EQ(sv[2], 50);
+  EXPECT_EQ(sv[0], 60);
+  EXPECT_EQ(sv.slot_count(), 5);
+
+  sv.clear();
+  EXPECT_EQ(sv.slot_count(), 0);
+  EXPECT_EQ(*sv.push_back(3), 0);
+}
+
+TEST(StaticStableVectorTest, Exhaustion) {
+  crystal::static_stable_vector<int, 3> sv;
+  for (int i = 0; i < 3; ++i) ASSERT_TRUE(sv.push_back(i));
+  EXPECT_TRUE(sv.full());
+
+  auto res = sv.insert(3);
+  ASSERT_FALSE(res);
+  EXPECT_EQ(res.error().category(), crystal::ErrorCategory::kCapacity);
+
+  /* push_back never reuses a slot, insert does. */
+  sv.erase(1);
+  EXPECT_FALSE(sv.full());
+  EXPECT_FALSE(sv.push_back(4));
+  EXPECT_EQ(*sv.insert(5), 1);
+}
+
+TEST(StaticStableVectorTest, ElementLifetimes) {
+  auto tracker = std::make_shared<int>(0);
+  {
+    crystal::static_stable_vector<std::shared_ptr<int>, 130> sv;
+    for (int i = 0; i < 130; ++i) ASSERT_TRUE(sv.emplace_back(tracker));
+    EXPECT_EQ(tracker.use_count(), 131);
+    sv.erase(64);
+    EXPECT_EQ(tracker.use_count(), 130);
+
+    auto copy = sv;
+    EXPECT_EQ(tracker.use_count(), 259);
+    EXPECT_FALSE(copy.occupied(64));
+    EXPECT_EQ(*copy.insert(tracker), 64);
+
+    auto moved = std::move(copy);
+    EXPECT_EQ(moved.slot_count(), 130);
+    copy = moved;
+    moved = std::move(sv);
+    EXPECT_FALSE(moved.occupied(64));
+  }
+  EXPECT_EQ(tracker.use_count(), 1);
+}
+
+TEST(StaticStableVectorTest, ThrowingCopyDestroysCopied) {
+  {
+    crystal::static_stable_vector<Counted, 8> sv;
+    for (int i = 0; i < 6; ++i) ASSERT_TRUE(sv.emplace_back(i));
+    sv.erase(1);
+    Counted::throw_at = 4;
+    EXPECT_THROW(auto copy = sv, std::runtime_error);
+    EXPECT_EQ(Counted::live, 5);
+
+    crystal::static_stable_vector<Counted, 8> target;
+    ASSERT_TRUE(target.emplace_back(9));
+    EXPECT_THROW(target = sv, std::runtime_error);
+    EXPECT_EQ(Counted::live, 8);
+    EXPECT_EQ(target.slot_count(), 4);
+    EXPECT_EQ(target[3].n, 3);
+    Counted::throw_at = -1;
+  }
+  EXPECT_EQ(Counted::live, 0);
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "CrystalBase/string_search.h"
+
+namespace {
+
+constexpr size_t npos = std::string_view::npos;
+
+/* Random text over a small alphabet, so partial matches are frequent. */
+std::string RandomText(size_t size, unsigned seed) {
+  std::mt19937 rng{ seed };
+  std::string text(size, 'a');
+  for (char& c : text) c = "abc"[rng() % 3];
+  return text;
+}
+
+template <crystal::fixed_string kPattern>
+void ExpectLikeStd(std::string_view text) {
+  const std::string_view pattern = kPattern;
+  for (size_t pos = 0; pos <= text.size() + 1; ++pos) {
+    ASSERT_EQ(crystal::find<kPattern>(text, pos), text.find(pattern, pos))
+        << "pattern " << pattern << " from " << pos << " in " << text.size();
+  }
+}
+
+} // namespace
+
+TEST(StringSearch, Basics) {
+  EXPECT_EQ(crystal::find<"world">("hello world"), 6);
+  EXPECT_EQ(crystal::find<"o">("hello world"), 4);
+  EXPECT_EQ(crystal::find<"o">("hello world", 5), 7);
+  EXPECT_EQ(crystal::find<"">("abc", 2), 2);
+  EXPECT_EQ(crystal::find<"">("abc", 4), npos);
+  EXPECT_EQ(crystal::find<"abcd">("abc"), npos);
+  EXPECT_EQ(crystal::find<"abc">("abc", 1), npos);
+  EXPECT_EQ(crystal::find<"needle">(""), npos);
+}
+
+TEST(StringSearch, MatchesStdFind) {
+  /* Lengths around the SIMD block, so both the vector scan and the tail run. */
+  for (size_t size : { 0, 1, 15, 16, 17, 31, 32, 33, 47, 64, 100, 257 }) {
+    const std::string text = RandomText(size, static_cast<unsigned>(size));
+    ExpectLikeStd<"a">(text);
+    ExpectLikeStd<"ab">(text);
+    ExpectLikeStd<"cab">(text);
+    ExpectLikeStd<"abca">(text);
+    ExpectLikeStd<"aaaaa">(text);
+    ExpectLikeStd<"bcabcab">(text);
+    ExpectLikeStd<"abcabcabcabcabcabc">(text);
+  }
+  /* A match straddling the last block, and one in the final bytes. */
+  std::string text(200, 'x');
+  text.replace(30, 5, "hello");
+  text.replace(195, 5, "hello");
+  ExpectLikeStd<"hello">(text);
+}
+
+TEST(StringSearch, FindAny) {
+  using crystal::search_match;
+  EXPECT_EQ((crystal::find_any<"cat", "dog">("hot dog and cat")),
+            (search_match{ 4, 1 }));
+  EXPECT_EQ((crystal::find_any<"cat", "dog">("hot dog and cat", 5)),
+            (search_match{ 12, 0 }));
+  EXPECT_FALSE((crystal::find_any<"cat", "dog">("a bird")));
+  /* At the same position the first listed pattern wins. */
+  EXPECT_EQ((crystal::find_any<"abc", "ab">("xxabc")), (search_match{ 2, 0 }));
+  EXPECT_EQ((crystal::find_any<"ab", "abc">("xxabc")), (search_match{ 2, 0 }));
+
+  for (size_t size : { 3, 16, 40, 100, 300 }) {
+    const std::string text = RandomText(size, static_cast<unsigned>(size + 7));
+    for (size_t pos = 0; pos <= size; ++pos) {
+      size_t expected = npos;
+      for (std::string_view p : { "cbca", "aab", "bbbbbb" }) {
+        expected = std::min(expected, text.find(p, pos));
+      }
+      ASSERT_EQ((crystal::find_any<"cbca", "aab", "bbbbbb">(text, pos).pos),
+                expected);
+    }
+  }
+}
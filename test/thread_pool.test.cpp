@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CrystalBase/stable_vector.h"
+#include "CrystalBase/thread_pool.h"
+
+TEST(WorkStealingDeque, OwnerIsLifoThiefIsFifo) {
+  crystal::work_stealing_deque<int> deque{ 2 };
+  for (int i = 0; i < 10; ++i) deque.push(i); // grows past the capacity
+  EXPECT_EQ(deque.size(), 10);
+  EXPECT_EQ(deque.pop(), 9);
+  EXPECT_EQ(deque.steal(), 0);
+  EXPECT_EQ(deque.pop(), 8);
+  EXPECT_EQ(deque.steal(), 1);
+  while (deque.pop()) {}
+  EXPECT_TRUE(deque.empty());
+  EXPECT_EQ(deque.steal(), std::nullopt);
+}
+
+TEST(WorkStealingDeque, ConcurrentSteal) {
+  constexpr int kItems = 100000;
+  crystal::work_stealing_deque<int> deque;
+  std::atomic<bool> done = false;
+  std::atomic<long long> stolen_sum = 0;
+  std::vector<std::thread> thieves;
+  for (int t = 0; t < 3; ++t) {
+    thieves.emplace_back([&] {
+      long long sum = 0;
+      while (!done.load() || !deque.empty()) {
+        if (auto item = deque.steal()) sum += *item;
+      }
+      stolen_sum += sum;
+    });
+  }
+  long long popped_sum = 0;
+  for (int i = 1; i <= kItems; ++i) {
+    deque.push(i);
+    if (i % 3 == 0) {
+      if (auto item = deque.pop()) popped_sum += *item;
+    }
+  }
+  done = true;
+  for (auto& thief : thieves) thief.join();
+  /* Every item is taken exactly once. */
+  EXPECT_EQ(popped_sum + stolen_sum, 1ll * kItems * (kItems + 1) / 2);
+}
+
+TEST(ThreadPool, ParallelForVisitsEachIndexOnce) {
+  crystal::ThreadPool pool{ { .num_threads = 3 } };
+  EXPECT_EQ(pool.concurrency(), 4);
+  std::vector<std::atomic<int>> hits(10007);
+  pool.parallel_for(std::views::iota(size_t{ 0 }, hits.size()), 64, [&](size_t i) {
+    hits[i].fetch_add(1, std::memory_order_relaxed);
+  });
+  for (const auto& hit : hits) EXPECT_EQ(hit.load(), 1);
+
+  std::vector<int> values(1000, 1);
+  pool.parallel_for(values, 16, [](int& v) { v *= 2; });
+  EXPECT_EQ(std::accumulate(values.begin(), values.end(), 0), 2000);
+}
+
+TEST(ThreadPool, ParallelReduceKeepsOrder) {
+  crystal::ThreadPool pool{ { .num_threads = 2 } };
+  std::vector<std::string> words;
+  std::string expected;
+  for (int i = 0; i < 500; ++i) {
+    words.push_back(std::to_string(i));
+    expected += words.back();
+  }
+  /* String concatenation is associative but not commutative. */
+  auto joined = pool.parallel_reduce(words, 7, std::string{}, std::plus<>{});
+  EXPECT_EQ(joined, expected);
+
+  auto squares = pool.parallel_reduce(std::views::iota(int64_t{ 0 }, int64_t{ 1000 }),
+                                      10,
+                                      int64_t{ 0 },
+                                      std::plus<>{},
+                                      [](int64_t x) { return x * x; });
+  EXPECT_EQ(squares, 332833500);
+}
+
+TEST(ThreadPool, NestedAndConcurrentCallers) {
+  crystal::ThreadPool pool{ { .num_threads = 2 } };
+  std::atomic<int> count = 0;
+  auto nested = [&] {
+    pool.parallel_for(std::views::iota(0, 16), 1, [&](int) {
+      pool.parallel_for(std::views::iota(0, 16), 1, [&](int) { ++count; });
+    });
+  };
+  std::thread other{ nested };
+  nested();
+  other.join();
+  EXPECT_EQ(count.load(), 2 * 16 * 16);
+}
+
+TEST(ThreadPool, RethrowsFirstException) {
+  crystal::ThreadPool pool{ { .num_threads = 2 } };
+  EXPECT_THROW(pool.parallel_for(std::views::iota(0, 1000),
+                                 1,
+                                 [](int i) {
+                                   if (i == 500) throw std::runtime_error("500");
+                                 }),
+               std::runtime_error);
+  /* The pool stays usable. */
+  std::atomic<int> count = 0;
+  pool.parallel_for(std::views::iota(0, 100), 1, [&](int) { ++count; });
+  EXPECT_EQ(count.load(), 100);
+}
+
+TEST(ThreadPool, WithoutWorkers) {
+  crystal::ThreadPool pool{ { .num_threads = 0 } };
+  int sum = 0; // only the caller runs, no synchronization needed
+  pool.parallel_for(std::views::iota(0, 100), 3, [&](int i) { sum += i; });
+  EXPECT_EQ(sum, 4950);
+}
+
+TEST(ThreadPool, StableVectorSlots) {
+  crystal::stable_vector<int> vec;
+  for (int i = 0; i < 1000; ++i) (void)vec.push_back(i);
+  for (size_t i = 0; i < 1000; i += 2) vec.erase(i);
+  std::atomic<int> visited = 0;
+  crystal::parallel_for(vec, 32, [&](size_t idx, int& value) {
+    EXPECT_EQ(static_cast<size_t>(value), idx);
+    EXPECT_EQ(idx % 2, 1);
+    value = -value;
+    ++visited;
+  });
+  EXPECT_EQ(visited.load(), 500);
+  EXPECT_EQ(vec[1], -1);
+}
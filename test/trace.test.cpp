@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#define CRYSTAL_ENABLE_TRACING 1
+#include "CrystalBase/trace.h"
+
+namespace {
+
+void Traced() {
+  CRYSTAL_TRACE_SCOPE("trace_test_inner");
+}
+
+} // namespace
+
+TEST(TraceTest, CompileTimeIds) {
+  static_assert(crystal::TraceName<"a">::kId != crystal::TraceName<"b">::kId);
+  static_assert(crystal::TraceName<"a">::kId == crystal::Fnv1a("a"));
+}
+
+TEST(TraceTest, ExportChromeTrace) {
+  {
+    CRYSTAL_TRACE_SCOPE("trace_test_outer");
+    Traced();
+  }
+  std::thread{ [] { Traced(); } }.join();
+
+  std::ostringstream os;
+  crystal::WriteChromeTrace(os);
+  std::string json = os.str();
+  EXPECT_NE(json.find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"trace_test_outer\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"trace_test_inner\""), std::string::npos);
+  EXPECT_NE(json.find("\"tid\":1"), std::string::npos);
+  /* The clock origin is anchored before the first span, not at export. */
+  EXPECT_EQ(json.find("\"ts\":-"), std::string::npos);
+
+  /* Records are consumed by the export. */
+  std::ostringstream again;
+  crystal::WriteChromeTrace(again);
+  EXPECT_EQ(again.str().find("trace_test_outer"), std::string::npos);
+}
+
+TEST(TraceTest, EscapesNames) {
+  {
+    CRYSTAL_TRACE_SCOPE("quote\" back\\slash\ttab");
+  }
+  std::ostringstream os;
+  crystal::WriteChromeTrace(os);
+  EXPECT_NE(os.str().find(R"("name":"quote\" back\\slash\u0009tab")"),
+            std::string::npos);
+}
+
+TEST(TraceTest, ReleasesBuffersOfExitedThreads) {
+  std::ostringstream os;
+  crystal::WriteChromeTrace(os);
+  const size_t buffers = crystal::TraceRegistry::Instance().buffer_count();
+  for (int i = 0; i < 16; ++i) std::thread{ [] { Traced(); } }.join();
+
+  std::ostringstream churn;
+  crystal::WriteChromeTrace(churn);
+  const std::string json = churn.str();
+  size_t spans = 0;
+  for (size_t pos = json.find("trace_test_inner"); pos != std::string::npos;
+       pos = json.find("trace_test_inner", pos + 1)) {
+    ++spans;
+  }
+  EXPECT_EQ(spans, 16);
+  EXPECT_EQ(crystal::TraceRegistry::Instance().buffer_count(), buffers);
+}
+
+TEST(TraceTest, RingBufferOverwrite) {
+  crystal::TraceBuffer buffer{ 0 };
+  const uint64_t n = crystal::TraceBuffer::kCapacity + 10;
+  for (uint64_t i = 0; i < n; ++i) buffer.Push(i, i, i + 1);
+  std::vector<crystal::TraceRecord> records;
+  buffer.Drain(records);
+  ASSERT_FALSE(records.empty());
+  EXPECT_LE(records.size(), crystal::TraceBuffer::kCapacity);
+  EXPECT_EQ(records.back().id, n - 1);
+  for (size_t i = 1; i < records.size(); ++i) {
+    EXPECT_EQ(records[i].id, records[i - 1].id + 1);
+  }
+}